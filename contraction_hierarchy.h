@@ -0,0 +1,445 @@
+#pragma once
+#include "graph.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <transport_router.pb.h>
+
+namespace graph {
+
+//Contraction Hierarchies: вершины "стягиваются" по очереди, кратчайшие пути через стянутую
+//вершину заменяются шорткатами. Запрос — двунаправленный поиск только "вверх" по порядку стягивания,
+//найденные шорткаты раскрываются обратно в рёбра исходного графа.
+template <typename Weight>
+class ContractionHierarchy {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+    using QueueItem = std::pair<Weight, VertexId>;
+    using Queue = std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>>;
+
+    static constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+
+    //ребро иерархии: либо исходное ребро графа (second == NO_EDGE, first — его id),
+    //либо шорткат из двух рёбер иерархии first и second
+    struct ChEdge {
+        VertexId from;
+        VertexId to;
+        Weight weight;
+        EdgeId first;
+        EdgeId second;
+    };
+
+    struct Arc {
+        VertexId vertex;
+        Weight weight;
+        EdgeId ch_edge;
+    };
+
+public:
+    using RouteInfo = graph::RouteInfo<Weight>;
+
+    explicit ContractionHierarchy(const Graph& graph);
+    ContractionHierarchy(const Graph& graph, const transport_catalog_serialize::ContractionHierarchy& data);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+
+    transport_catalog_serialize::ContractionHierarchy GetSerializeData() const;
+
+    //число вершин, извлечённых из очередей последним запросом (в обоих направлениях)
+    size_t GetExpandedVertexCount() const {
+        return expanded_vertices_;
+    }
+
+private:
+    //---предобработка---
+    void Contract();
+    //число шорткатов при стягивании vertex; при add_shortcuts == true они добавляются
+    int ContractVertex(VertexId vertex, bool add_shortcuts);
+    //есть ли путь from -> to не длиннее limit в оставшемся графе без вершины excluded
+    void WitnessSearch(VertexId from, VertexId excluded, Weight limit);
+    int Priority(VertexId vertex);
+    void AddArc(VertexId from, VertexId to, Weight weight, EdgeId ch_edge);
+
+    //---запрос---
+    //одна сторона двунаправленного поиска
+    struct Search {
+        std::vector<Weight> weights;
+        std::vector<EdgeId> prev_edge;
+        std::vector<uint32_t> epoch;
+
+        bool IsReached(VertexId vertex, uint32_t current) const {
+            return epoch[vertex] == current;
+        }
+    };
+    void BuildAdjacency();
+    void UnpackEdge(EdgeId ch_edge, std::vector<EdgeId>& edges) const;
+
+    static constexpr Weight ZERO_WEIGHT{};
+    //ограничение поиска свидетелей: при превышении шорткат добавляется "на всякий случай"
+    static constexpr size_t WITNESS_SETTLED_LIMIT = 500;
+
+    const Graph& graph_;
+    std::vector<uint32_t> rank_;
+    std::vector<ChEdge> ch_edges_;
+    //рёбра вверх по рангу: up_out_[v] — из v, down_in_[v] — в v из более высоких вершин
+    std::vector<std::vector<Arc>> up_out_;
+    std::vector<std::vector<Arc>> down_in_;
+
+    //рабочие данные предобработки
+    std::vector<std::vector<Arc>> out_;
+    std::vector<std::vector<Arc>> in_;
+    std::vector<bool> contracted_;
+    std::vector<int> contracted_neighbors_;
+    std::vector<Weight> witness_weights_;
+    std::vector<uint32_t> witness_epoch_;
+    uint32_t witness_current_ = 0;
+
+    mutable Search forward_;
+    mutable Search backward_;
+    mutable uint32_t epoch_ = 0;
+    mutable size_t expanded_vertices_ = 0;
+};
+
+template <typename Weight>
+ContractionHierarchy<Weight>::ContractionHierarchy(const Graph& graph)
+    : graph_(graph)
+{
+    const size_t vertex_count = graph.GetVertexCount();
+    out_.resize(vertex_count);
+    in_.resize(vertex_count);
+    //из параллельных рёбер остаётся самое лёгкое
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+            const auto edge = graph.GetEdge(edge_id);
+            if (edge.weight < ZERO_WEIGHT) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+            if (edge.from == edge.to) {
+                continue;
+            }
+            ch_edges_.push_back({edge.from, edge.to, edge.weight, edge_id, NO_EDGE});
+            AddArc(edge.from, edge.to, edge.weight, ch_edges_.size() - 1);
+        }
+    }
+    Contract();
+    BuildAdjacency();
+}
+
+template <typename Weight>
+ContractionHierarchy<Weight>::ContractionHierarchy(const Graph& graph,
+                                                   const transport_catalog_serialize::ContractionHierarchy& data)
+    : graph_(graph)
+    , rank_(data.rank().begin(), data.rank().end())
+{
+    const size_t vertex_count = graph.GetVertexCount();
+    const int edge_count = data.from_size();
+    const int weight_count = data.float_weight_size() > 0 ? data.float_weight_size() : data.weight_size();
+    if (rank_.size() != vertex_count || data.to_size() != edge_count || data.first_size() != edge_count
+            || data.second_size() != edge_count || weight_count != edge_count) {
+        throw std::invalid_argument("Inconsistent contraction hierarchy data");
+    }
+    ch_edges_.reserve(edge_count);
+    for (int i = 0; i < edge_count; ++i) {
+        //исходное ребро ссылается на ребро графа, шорткат — на две более ранние записи иерархии,
+        //так что раскрытие шорткатов всегда конечно
+        const bool is_shortcut = data.second(i) >= 0;
+        const size_t first_limit = is_shortcut ? static_cast<size_t>(i) : graph.GetEdgeCount();
+        if (data.from(i) >= vertex_count || data.to(i) >= vertex_count || data.first(i) >= first_limit
+                || (is_shortcut && data.second(i) >= i)) {
+            throw std::invalid_argument("Inconsistent contraction hierarchy data");
+        }
+        const Weight weight = data.float_weight_size() > 0 ? static_cast<Weight>(data.float_weight(i))
+                                                           : static_cast<Weight>(data.weight(i));
+        ch_edges_.push_back({data.from(i), data.to(i), weight,
+                             static_cast<EdgeId>(data.first(i)),
+                             is_shortcut ? static_cast<EdgeId>(data.second(i)) : NO_EDGE});
+    }
+    BuildAdjacency();
+}
+
+template <typename Weight>
+transport_catalog_serialize::ContractionHierarchy ContractionHierarchy<Weight>::GetSerializeData() const {
+    transport_catalog_serialize::ContractionHierarchy data_out;
+    data_out.mutable_rank()->Add(rank_.begin(), rank_.end());
+    for (const ChEdge& edge : ch_edges_) {
+        data_out.add_from(static_cast<uint32_t>(edge.from));
+        data_out.add_to(static_cast<uint32_t>(edge.to));
+        if constexpr (std::is_same_v<Weight, float>) {
+            data_out.add_float_weight(edge.weight);
+        } else {
+            data_out.add_weight(edge.weight);
+        }
+        data_out.add_first(static_cast<uint32_t>(edge.first));
+        data_out.add_second(edge.second == NO_EDGE ? -1 : static_cast<int64_t>(edge.second));
+    }
+    return data_out;
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::AddArc(VertexId from, VertexId to, Weight weight, EdgeId ch_edge) {
+    auto it = std::find_if(out_[from].begin(), out_[from].end(), [to](const Arc& arc) { return arc.vertex == to; });
+    if (it != out_[from].end()) {
+        if (it->weight <= weight) {
+            return;
+        }
+        *it = {to, weight, ch_edge};
+        *std::find_if(in_[to].begin(), in_[to].end(), [from](const Arc& arc) { return arc.vertex == from; })
+                = {from, weight, ch_edge};
+        return;
+    }
+    out_[from].push_back({to, weight, ch_edge});
+    in_[to].push_back({from, weight, ch_edge});
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::WitnessSearch(VertexId from, VertexId excluded, Weight limit) {
+    if (++witness_current_ == 0) {
+        std::fill(witness_epoch_.begin(), witness_epoch_.end(), 0);
+        witness_current_ = 1;
+    }
+    Queue queue;
+    witness_epoch_[from] = witness_current_;
+    witness_weights_[from] = ZERO_WEIGHT;
+    queue.push({ZERO_WEIGHT, from});
+    for (size_t settled = 0; !queue.empty() && settled < WITNESS_SETTLED_LIMIT; ++settled) {
+        const auto [weight, vertex] = queue.top();
+        queue.pop();
+        if (weight > witness_weights_[vertex]) {
+            continue;
+        }
+        if (limit < weight) {
+            break;
+        }
+        for (const Arc& arc : out_[vertex]) {
+            if (contracted_[arc.vertex] || arc.vertex == excluded) {
+                continue;
+            }
+            const Weight candidate_weight = weight + arc.weight;
+            if (witness_epoch_[arc.vertex] != witness_current_ || candidate_weight < witness_weights_[arc.vertex]) {
+                witness_epoch_[arc.vertex] = witness_current_;
+                witness_weights_[arc.vertex] = candidate_weight;
+                queue.push({candidate_weight, arc.vertex});
+            }
+        }
+    }
+}
+
+template <typename Weight>
+int ContractionHierarchy<Weight>::ContractVertex(VertexId vertex, bool add_shortcuts) {
+    int shortcuts = 0;
+    //копии: при добавлении шорткатов списки смежности соседей меняются
+    const std::vector<Arc> in_arcs = in_[vertex];
+    const std::vector<Arc> out_arcs = out_[vertex];
+    for (const Arc& in_arc : in_arcs) {
+        if (contracted_[in_arc.vertex]) {
+            continue;
+        }
+        Weight limit = ZERO_WEIGHT;
+        for (const Arc& out_arc : out_arcs) {
+            if (!contracted_[out_arc.vertex] && out_arc.vertex != in_arc.vertex) {
+                limit = std::max(limit, in_arc.weight + out_arc.weight);
+            }
+        }
+        WitnessSearch(in_arc.vertex, vertex, limit);
+        for (const Arc& out_arc : out_arcs) {
+            if (contracted_[out_arc.vertex] || out_arc.vertex == in_arc.vertex) {
+                continue;
+            }
+            const Weight weight = in_arc.weight + out_arc.weight;
+            if (witness_epoch_[out_arc.vertex] == witness_current_ && witness_weights_[out_arc.vertex] <= weight) {
+                continue;
+            }
+            ++shortcuts;
+            if (add_shortcuts) {
+                ch_edges_.push_back({in_arc.vertex, out_arc.vertex, weight, in_arc.ch_edge, out_arc.ch_edge});
+                AddArc(in_arc.vertex, out_arc.vertex, weight, ch_edges_.size() - 1);
+            }
+        }
+    }
+    return shortcuts;
+}
+
+template <typename Weight>
+int ContractionHierarchy<Weight>::Priority(VertexId vertex) {
+    int degree = 0;
+    for (const Arc& arc : in_[vertex]) {
+        degree += contracted_[arc.vertex] ? 0 : 1;
+    }
+    for (const Arc& arc : out_[vertex]) {
+        degree += contracted_[arc.vertex] ? 0 : 1;
+    }
+    //разность рёбер плюс число уже стянутых соседей (равномерность стягивания)
+    return ContractVertex(vertex, false) - degree + contracted_neighbors_[vertex];
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::Contract() {
+    const size_t vertex_count = graph_.GetVertexCount();
+    rank_.assign(vertex_count, 0);
+    contracted_.assign(vertex_count, false);
+    contracted_neighbors_.assign(vertex_count, 0);
+    witness_weights_.assign(vertex_count, ZERO_WEIGHT);
+    witness_epoch_.assign(vertex_count, 0);
+
+    using PriorityItem = std::pair<int, VertexId>;
+    std::priority_queue<PriorityItem, std::vector<PriorityItem>, std::greater<PriorityItem>> queue;
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        queue.push({Priority(vertex), vertex});
+    }
+    uint32_t next_rank = 0;
+    while (!queue.empty()) {
+        const VertexId vertex = queue.top().second;
+        queue.pop();
+        if (contracted_[vertex]) {
+            continue;
+        }
+        //ленивое обновление: если приоритет устарел и вершина уже не минимальна, откладываем
+        const int priority = Priority(vertex);
+        if (!queue.empty() && priority > queue.top().first) {
+            queue.push({priority, vertex});
+            continue;
+        }
+        ContractVertex(vertex, true);
+        contracted_[vertex] = true;
+        rank_[vertex] = next_rank++;
+        for (const Arc& arc : in_[vertex]) {
+            ++contracted_neighbors_[arc.vertex];
+        }
+        for (const Arc& arc : out_[vertex]) {
+            ++contracted_neighbors_[arc.vertex];
+        }
+    }
+
+    out_ = {};
+    in_ = {};
+    contracted_ = {};
+    contracted_neighbors_ = {};
+    witness_weights_ = {};
+    witness_epoch_ = {};
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::BuildAdjacency() {
+    const size_t vertex_count = graph_.GetVertexCount();
+    //у каждой пары вершин остаётся самое лёгкое ребро иерархии
+    up_out_.assign(vertex_count, {});
+    down_in_.assign(vertex_count, {});
+    for (EdgeId edge_id = 0; edge_id < ch_edges_.size(); ++edge_id) {
+        const ChEdge& edge = ch_edges_[edge_id];
+        auto& arcs = rank_[edge.from] < rank_[edge.to] ? up_out_[edge.from] : down_in_[edge.to];
+        const VertexId other = rank_[edge.from] < rank_[edge.to] ? edge.to : edge.from;
+        auto it = std::find_if(arcs.begin(), arcs.end(), [other](const Arc& arc) { return arc.vertex == other; });
+        if (it == arcs.end()) {
+            arcs.push_back({other, edge.weight, edge_id});
+        } else if (edge.weight < it->weight) {
+            *it = {other, edge.weight, edge_id};
+        }
+    }
+    for (Search* search : {&forward_, &backward_}) {
+        search->weights.assign(vertex_count, ZERO_WEIGHT);
+        search->prev_edge.assign(vertex_count, NO_EDGE);
+        search->epoch.assign(vertex_count, 0);
+    }
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::UnpackEdge(EdgeId ch_edge, std::vector<EdgeId>& edges) const {
+    std::vector<EdgeId> stack = {ch_edge};
+    while (!stack.empty()) {
+        const ChEdge& edge = ch_edges_[stack.back()];
+        stack.pop_back();
+        if (edge.second == NO_EDGE) {
+            edges.push_back(edge.first);
+        } else {
+            stack.push_back(edge.second);
+            stack.push_back(edge.first);
+        }
+    }
+}
+
+template <typename Weight>
+std::optional<typename ContractionHierarchy<Weight>::RouteInfo> ContractionHierarchy<Weight>::BuildRoute(
+        VertexId from, VertexId to) const {
+    if (from >= graph_.GetVertexCount() || to >= graph_.GetVertexCount()) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    if (++epoch_ == 0) {
+        std::fill(forward_.epoch.begin(), forward_.epoch.end(), 0);
+        std::fill(backward_.epoch.begin(), backward_.epoch.end(), 0);
+        epoch_ = 1;
+    }
+    expanded_vertices_ = 0;
+    Queue forward_queue;
+    Queue backward_queue;
+    auto reach = [this](Search& search, Queue& queue, VertexId vertex, Weight weight, EdgeId prev_edge) {
+        search.epoch[vertex] = epoch_;
+        search.weights[vertex] = weight;
+        search.prev_edge[vertex] = prev_edge;
+        queue.push({weight, vertex});
+    };
+    reach(forward_, forward_queue, from, ZERO_WEIGHT, NO_EDGE);
+    reach(backward_, backward_queue, to, ZERO_WEIGHT, NO_EDGE);
+
+    std::optional<Weight> best;
+    VertexId meeting = from;
+    auto step = [&](Search& search, Queue& queue, const std::vector<std::vector<Arc>>& arcs,
+                    const Search& other) {
+        const auto [weight, vertex] = queue.top();
+        queue.pop();
+        if (weight > search.weights[vertex]) {
+            return;
+        }
+        ++expanded_vertices_;
+        if (other.IsReached(vertex, epoch_)) {
+            const Weight total = weight + other.weights[vertex];
+            if (!best || total < *best) {
+                best = total;
+                meeting = vertex;
+            }
+        }
+        for (const Arc& arc : arcs[vertex]) {
+            const Weight candidate_weight = weight + arc.weight;
+            if (!search.IsReached(arc.vertex, epoch_) || candidate_weight < search.weights[arc.vertex]) {
+                reach(search, queue, arc.vertex, candidate_weight, arc.ch_edge);
+            }
+        }
+    };
+    //направление останавливается, когда его минимум в очереди не меньше лучшего найденного пути
+    while (true) {
+        const bool forward_active = !forward_queue.empty() && (!best || forward_queue.top().first < *best);
+        const bool backward_active = !backward_queue.empty() && (!best || backward_queue.top().first < *best);
+        if (!forward_active && !backward_active) {
+            break;
+        }
+        if (forward_active && (!backward_active || forward_queue.top().first <= backward_queue.top().first)) {
+            step(forward_, forward_queue, up_out_, backward_);
+        } else {
+            step(backward_, backward_queue, down_in_, forward_);
+        }
+    }
+    if (!best) {
+        return std::nullopt;
+    }
+
+    std::vector<EdgeId> forward_edges;
+    for (VertexId vertex = meeting; forward_.prev_edge[vertex] != NO_EDGE; vertex = ch_edges_[forward_.prev_edge[vertex]].from) {
+        forward_edges.push_back(forward_.prev_edge[vertex]);
+    }
+    std::vector<EdgeId> edges;
+    for (auto it = forward_edges.rbegin(); it != forward_edges.rend(); ++it) {
+        UnpackEdge(*it, edges);
+    }
+    for (VertexId vertex = meeting; backward_.prev_edge[vertex] != NO_EDGE; vertex = ch_edges_[backward_.prev_edge[vertex]].to) {
+        UnpackEdge(backward_.prev_edge[vertex], edges);
+    }
+    return RouteInfo{*best, std::move(edges)};
+}
+}
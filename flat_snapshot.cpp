@@ -0,0 +1,155 @@
+#include "flat_snapshot.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define FLAT_SNAPSHOT_MMAP
+#endif
+
+namespace serialize {
+namespace flat {
+
+using namespace std::literals;
+
+namespace {
+
+constexpr size_t SECTION_COUNT = static_cast<size_t>(SectionId::COUNT);
+
+size_t AlignUp(size_t value) {
+    return (value + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+}
+
+}
+
+size_t Writer::Write(const std::filesystem::path& path, uint32_t weight_size) const {
+    Header header{MAGIC, VERSION, BYTE_ORDER_MARK, weight_size, static_cast<uint32_t>(SECTION_COUNT)};
+    std::array<Section, SECTION_COUNT> table{};
+    size_t offset = AlignUp(sizeof(Header) + sizeof(table));
+    for (size_t id = 0; id < SECTION_COUNT; ++id) {
+        if (!sections_[id].empty()) {
+            table[id] = {offset, sections_[id].size()};
+            offset = AlignUp(offset + sections_[id].size());
+        }
+    }
+
+    std::filesystem::path temp_path = path;
+    temp_path += ".tmp"s;
+    {
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            throw std::runtime_error("Cannot open "s + temp_path.string());
+        }
+        const char padding[SECTION_ALIGNMENT] = {};
+        size_t written = 0;
+        auto write = [&out, &written, &padding](std::string_view bytes) {
+            out.write(padding, AlignUp(written) - written);
+            written = AlignUp(written);
+            out.write(bytes.data(), bytes.size());
+            written += bytes.size();
+        };
+        write({reinterpret_cast<const char*>(&header), sizeof(header)});
+        write({reinterpret_cast<const char*>(table.data()), sizeof(table)});
+        for (const std::string_view section : sections_) {
+            if (!section.empty()) {
+                write(section);
+            }
+        }
+        if (!out) {
+            throw std::runtime_error("Cannot write "s + temp_path.string());
+        }
+    }
+    std::filesystem::rename(temp_path, path);
+    return std::filesystem::file_size(path);
+}
+
+MappedSnapshot::MappedSnapshot(const std::filesystem::path& path) {
+#ifdef FLAT_SNAPSHOT_MMAP
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open "s + path.string());
+    }
+    struct stat file_stat{};
+    if (::fstat(fd, &file_stat) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Cannot stat "s + path.string());
+    }
+    size_t size = static_cast<size_t>(file_stat.st_size);
+    if (size > 0) {
+        void* mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("Cannot map "s + path.string());
+        }
+        data_ = static_cast<const char*>(mapped);
+        size_ = size;
+    }
+    //отображение остаётся действительным и после закрытия дескриптора
+    ::close(fd);
+#else
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Cannot open "s + path.string());
+    }
+    buffer_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+#endif
+    try {
+        if (size_ < sizeof(Header)) {
+            throw std::invalid_argument("Flat snapshot is truncated");
+        }
+        std::memcpy(&header_, data_, sizeof(Header));
+        if (header_.magic != MAGIC) {
+            throw std::invalid_argument("Not a flat snapshot");
+        }
+        if (header_.version != VERSION || header_.byte_order != BYTE_ORDER_MARK) {
+            throw std::invalid_argument("Unsupported flat snapshot version or byte order");
+        }
+        if (size_ < sizeof(Header) + header_.section_count * sizeof(Section)) {
+            throw std::invalid_argument("Flat snapshot is truncated");
+        }
+        //секции, неизвестные этой версии, пропускаются, отсутствующие в файле — пусты
+        const size_t known_sections = std::min<size_t>(header_.section_count, SECTION_COUNT);
+        for (size_t id = 0; id < known_sections; ++id) {
+            Section section;
+            std::memcpy(&section, data_ + sizeof(Header) + id * sizeof(Section), sizeof(Section));
+            if (section.size == 0) {
+                continue;
+            }
+            if (section.offset % SECTION_ALIGNMENT != 0 || section.offset > size_ || section.size > size_ - section.offset) {
+                throw std::invalid_argument("Flat snapshot section is out of the file");
+            }
+            sections_[id] = {data_ + section.offset, section.size};
+        }
+    } catch (...) {
+#ifdef FLAT_SNAPSHOT_MMAP
+        if (data_) {
+            ::munmap(const_cast<char*>(data_), size_);
+        }
+#endif
+        throw;
+    }
+}
+
+MappedSnapshot::~MappedSnapshot() {
+#ifdef FLAT_SNAPSHOT_MMAP
+    if (data_) {
+        ::munmap(const_cast<char*>(data_), size_);
+    }
+#endif
+}
+
+bool MappedSnapshot::IsFlat(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::array<char, MAGIC.size()> magic{};
+    return in.read(magic.data(), magic.size()) && magic == MAGIC;
+}
+
+}
+}
@@ -0,0 +1,164 @@
+#pragma once
+#include "ranges.h"
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace serialize {
+
+//Плоский снапшот: заголовок, таблица секций и сами секции — массивы записей фиксированного размера,
+//каждая с границы 8 байт. Файл отображается в память, секции читаются на месте без разбора.
+//Порядок байт и размер веса — как у записавшей снапшот машины и сборки; они проверяются при открытии.
+namespace flat {
+
+enum class SectionId : uint32_t {
+    STRINGS,                //имена остановок и автобусов подряд, без разделителей
+    STOPS,                  //Stop по Stop::vertex_id
+    BUSES,                  //Bus по Bus::id
+    BUS_STOPS,              //vertex_id остановок автобусов (у некольцевого — до конечной, как во входных данных)
+    DISTANCES,              //Distance
+    RENDER_SETTINGS,        //сообщение RenderSettings (protobuf, несколько десятков байт)
+    ROUTING_SETTINGS,       //RoutingSettings, одна запись
+    GRAPH_OFFSETS,          //uint32_t, V + 1
+    GRAPH_TARGETS,          //uint32_t по id ребра
+    GRAPH_WEIGHTS,          //вес по id ребра
+    EDGE_INFO,              //EdgeInfo по id ребра
+    ROUTE_WEIGHTS,          //таблица маршрутов V×V построчно
+    ROUTE_PREV_EDGES,       //uint32_t, V×V
+    CONTRACTION_HIERARCHY,  //сообщение ContractionHierarchy (protobuf)
+    HUB_LABELS,             //сообщение HubLabels (protobuf)
+    STOP_BUSES,             //Bus::id автобусов через остановку в порядке возрастания имени
+    COUNT
+};
+
+struct Header {
+    std::array<char, 8> magic;
+    uint32_t version;
+    uint32_t byte_order;    //BYTE_ORDER_MARK в порядке байт записавшей машины
+    uint32_t weight_size;   //sizeof веса графа и таблицы маршрутов
+    uint32_t section_count;
+};
+
+//секция нулевого размера отсутствует
+struct Section {
+    uint64_t offset;
+    uint64_t size;
+};
+
+struct Stop {
+    double latitude;
+    double longitude;
+    uint32_t name_offset;   //в STRINGS
+    uint32_t name_size;
+    uint32_t buses_offset;  //в STOP_BUSES
+    uint32_t buses_count;
+};
+
+//статистика маршрута хранится готовой и при загрузке не пересчитывается
+struct Bus {
+    uint32_t name_offset;
+    uint32_t name_size;
+    uint32_t stops_offset;  //в BUS_STOPS
+    uint32_t stops_count;
+    uint32_t route_type;
+    uint32_t unique_stops;
+    uint32_t distance;
+    uint32_t reserved;
+    double curvature;
+};
+
+struct Distance {
+    uint32_t from;
+    uint32_t to;
+    uint32_t distance;
+};
+
+struct RoutingSettings {
+    uint32_t bus_wait_time;
+    uint32_t bus_velocity;
+    uint32_t router_type;
+    uint32_t graph_model;
+    uint32_t route_cache_mb;
+    uint32_t report_expanded_vertices;
+};
+
+struct EdgeInfo {
+    uint32_t stop;
+    uint32_t bus;
+    uint32_t count;
+    uint32_t type;
+};
+
+inline constexpr std::array<char, 8> MAGIC = {'T', 'C', 'F', 'L', 'A', 'T', '\0', '\0'};
+inline constexpr uint32_t VERSION = 2;
+inline constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+inline constexpr size_t SECTION_ALIGNMENT = 8;
+
+//собирает секции и пишет снапшот; данные секций не копируются и должны жить до Write
+class Writer {
+public:
+    template <typename T>
+    void AddSection(SectionId id, const T* data, size_t count) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        sections_[static_cast<size_t>(id)] = {reinterpret_cast<const char*>(data), count * sizeof(T)};
+    }
+    template <typename Container>
+    void AddSection(SectionId id, const Container& container) {
+        AddSection(id, container.data(), container.size());
+    }
+
+    //пишет во временный файл и переименовывает его в path: снапшот, отображённый в память
+    //читающим процессом, при этом не меняется. Возвращает размер файла
+    size_t Write(const std::filesystem::path& path, uint32_t weight_size) const;
+
+private:
+    std::array<std::string_view, static_cast<size_t>(SectionId::COUNT)> sections_;
+};
+
+//снапшот, отображённый в память только для чтения
+class MappedSnapshot {
+public:
+    explicit MappedSnapshot(const std::filesystem::path& path);
+    MappedSnapshot(const MappedSnapshot&) = delete;
+    MappedSnapshot& operator=(const MappedSnapshot&) = delete;
+    ~MappedSnapshot();
+
+    //файл начинается с заголовка плоского снапшота
+    static bool IsFlat(const std::filesystem::path& path);
+
+    uint32_t GetWeightSize() const {
+        return header_.weight_size;
+    }
+    bool HasSection(SectionId id) const {
+        return !GetBytes(id).empty();
+    }
+    std::string_view GetBytes(SectionId id) const {
+        return sections_[static_cast<size_t>(id)];
+    }
+    template <typename T>
+    ranges::Range<const T*> GetArray(SectionId id) const {
+        static_assert(std::is_trivially_copyable_v<T>);
+        const std::string_view bytes = GetBytes(id);
+        if (bytes.size() % sizeof(T) != 0) {
+            throw std::invalid_argument("Flat snapshot section has a wrong size");
+        }
+        const T* begin = reinterpret_cast<const T*>(bytes.data());
+        return {begin, begin + bytes.size() / sizeof(T)};
+    }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    //без mmap файл читается целиком в буфер
+    std::vector<char> buffer_;
+    Header header_{};
+    std::array<std::string_view, static_cast<size_t>(SectionId::COUNT)> sections_;
+};
+
+}
+}
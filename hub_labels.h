@@ -0,0 +1,312 @@
+#pragma once
+#include "graph.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <transport_router.pb.h>
+
+namespace graph {
+
+//Хаб-метки (2-hop labels): у каждой вершины v есть исходящая метка — хабы x с весом пути v -> x —
+//и входящая — хабы x с весом пути x -> v. Вес пути from -> to — минимум по общим хабам
+//исходящей метки from и входящей метки to; метки отсортированы по рангу хаба, пересечение — слиянием.
+//Строятся обрезанными поисками Дейкстры (pruned landmark labeling) в порядке убывания степени вершин.
+template <typename Weight>
+class HubLabels {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+    using QueueItem = std::pair<Weight, VertexId>;
+    using Queue = std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>>;
+    //метки одного направления одним блоком: метка v — [offsets[v], offsets[v + 1]) в hubs/weights
+    struct Labels {
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> hubs;     //ранг хаба
+        std::vector<Weight> weights;
+    };
+    using LabelList = std::vector<std::vector<std::pair<uint32_t, Weight>>>;
+
+public:
+    using RouteInfo = graph::RouteInfo<Weight>;
+
+    explicit HubLabels(const Graph& graph);
+    HubLabels(const Graph& graph, const transport_catalog_serialize::HubLabels& data);
+
+    //вес кратчайшего пути — только слияние меток, без поиска по графу
+    std::optional<Weight> GetWeight(VertexId from, VertexId to) const;
+    //маршрут: A* по графу, где оценка остатка пути — его точный вес по меткам. Раскрываются почти
+    //только вершины кратчайшего пути, а рёбра нулевого веса не сбивают восстановление
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+
+    transport_catalog_serialize::HubLabels GetSerializeData() const;
+
+private:
+    //обрезанный поиск от хаба rank-й вершины; forward — по исходящим рёбрам (заполняет входящие метки)
+    void PrunedSearch(VertexId hub, uint32_t rank, bool forward,
+                      const std::vector<std::vector<EdgeId>>& incoming, LabelList& out, LabelList& in);
+    static Labels Flatten(const LabelList& labels);
+
+    static constexpr Weight ZERO_WEIGHT{};
+    static constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+    const Graph& graph_;
+    Labels out_;
+    Labels in_;
+
+    //рабочие данные построения
+    std::vector<Weight> search_weights_;
+    std::vector<uint32_t> search_epoch_;
+    std::vector<Weight> hub_weights_;
+    std::vector<uint32_t> hub_epoch_;
+    uint32_t epoch_ = 0;
+
+    //рабочие данные восстановления маршрута: вес пути от начала, оценка остатка, ребро-предок
+    struct RouteVertex {
+        Weight weight;
+        std::optional<Weight> rest;
+        EdgeId prev_edge;
+    };
+    mutable std::vector<RouteVertex> route_vertices_;
+    mutable std::vector<uint32_t> route_epoch_;
+    mutable uint32_t route_current_ = 0;
+};
+
+template <typename Weight>
+HubLabels<Weight>::HubLabels(const Graph& graph)
+    : graph_(graph)
+{
+    const size_t vertex_count = graph.GetVertexCount();
+    std::vector<std::vector<EdgeId>> incoming(vertex_count);
+    std::vector<size_t> degree(vertex_count, 0);
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        const auto edge = graph.GetEdge(edge_id);
+        if (edge.weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+        incoming[edge.to].push_back(edge_id);
+        ++degree[edge.from];
+        ++degree[edge.to];
+    }
+    //хабы — сначала вершины с большей степенью: через них проходит больше кратчайших путей
+    std::vector<VertexId> order(vertex_count);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&degree](VertexId lhs, VertexId rhs) {
+        return degree[lhs] > degree[rhs];
+    });
+
+    search_weights_.resize(vertex_count);
+    search_epoch_.assign(vertex_count, 0);
+    hub_weights_.resize(vertex_count);
+    hub_epoch_.assign(vertex_count, 0);
+    LabelList out(vertex_count);
+    LabelList in(vertex_count);
+    for (uint32_t rank = 0; rank < vertex_count; ++rank) {
+        PrunedSearch(order[rank], rank, true, incoming, out, in);
+        PrunedSearch(order[rank], rank, false, incoming, out, in);
+    }
+    out_ = Flatten(out);
+    in_ = Flatten(in);
+    search_weights_ = {};
+    search_epoch_ = {};
+    hub_weights_ = {};
+    hub_epoch_ = {};
+    route_vertices_.resize(vertex_count);
+    route_epoch_.assign(vertex_count, 0);
+}
+
+template <typename Weight>
+HubLabels<Weight>::HubLabels(const Graph& graph, const transport_catalog_serialize::HubLabels& data)
+    : graph_(graph)
+{
+    out_ = {{data.out_offsets().begin(), data.out_offsets().end()},
+            {data.out_hubs().begin(), data.out_hubs().end()},
+            LoadWeights<Weight>(data.out_weights(), data.out_float_weights())};
+    in_ = {{data.in_offsets().begin(), data.in_offsets().end()},
+           {data.in_hubs().begin(), data.in_hubs().end()},
+           LoadWeights<Weight>(data.in_weights(), data.in_float_weights())};
+    for (const Labels* labels : {&out_, &in_}) {
+        if (labels->offsets.size() != graph.GetVertexCount() + 1 || labels->hubs.size() != labels->weights.size()
+                || labels->offsets.back() != labels->hubs.size()) {
+            throw std::invalid_argument("Inconsistent hub labels data");
+        }
+    }
+    route_vertices_.resize(graph.GetVertexCount());
+    route_epoch_.assign(graph.GetVertexCount(), 0);
+}
+
+template <typename Weight>
+void HubLabels<Weight>::PrunedSearch(VertexId hub, uint32_t rank, bool forward,
+                                     const std::vector<std::vector<EdgeId>>& incoming,
+                                     LabelList& out, LabelList& in) {
+    if (++epoch_ == 0) {
+        std::fill(search_epoch_.begin(), search_epoch_.end(), 0);
+        std::fill(hub_epoch_.begin(), hub_epoch_.end(), 0);
+        epoch_ = 1;
+    }
+    //метка хаба "со своей стороны" в плотном массиве: проверка вершины — один проход по её метке
+    LabelList& hub_side = forward ? out : in;
+    LabelList& vertex_side = forward ? in : out;
+    for (const auto& [hub_rank, weight] : hub_side[hub]) {
+        hub_epoch_[hub_rank] = epoch_;
+        hub_weights_[hub_rank] = weight;
+    }
+    Queue queue;
+    search_epoch_[hub] = epoch_;
+    search_weights_[hub] = ZERO_WEIGHT;
+    queue.push({ZERO_WEIGHT, hub});
+    while (!queue.empty()) {
+        const Weight weight = queue.top().first;
+        const VertexId vertex = queue.top().second;
+        queue.pop();
+        if (weight > search_weights_[vertex]) {
+            continue;
+        }
+        //путь уже покрыт хабами выше по рангу — вершина не получает метку и не раскрывается
+        bool covered = false;
+        for (const auto& [hub_rank, label_weight] : vertex_side[vertex]) {
+            if (hub_epoch_[hub_rank] == epoch_ && hub_weights_[hub_rank] + label_weight <= weight) {
+                covered = true;
+                break;
+            }
+        }
+        if (covered) {
+            continue;
+        }
+        vertex_side[vertex].push_back({rank, weight});
+        auto relax = [&](VertexId next, Weight edge_weight) {
+            const Weight candidate_weight = weight + edge_weight;
+            if (search_epoch_[next] != epoch_ || candidate_weight < search_weights_[next]) {
+                search_epoch_[next] = epoch_;
+                search_weights_[next] = candidate_weight;
+                queue.push({candidate_weight, next});
+            }
+        };
+        if (forward) {
+            for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+                const auto edge = graph_.GetEdge(edge_id);
+                relax(edge.to, edge.weight);
+            }
+        } else {
+            for (const EdgeId edge_id : incoming[vertex]) {
+                const auto edge = graph_.GetEdge(edge_id);
+                relax(edge.from, edge.weight);
+            }
+        }
+    }
+}
+
+template <typename Weight>
+typename HubLabels<Weight>::Labels HubLabels<Weight>::Flatten(const LabelList& labels) {
+    Labels result;
+    result.offsets.reserve(labels.size() + 1);
+    result.offsets.push_back(0);
+    for (const auto& label : labels) {
+        for (const auto& [hub_rank, weight] : label) {
+            result.hubs.push_back(hub_rank);
+            result.weights.push_back(weight);
+        }
+        result.offsets.push_back(static_cast<uint32_t>(result.hubs.size()));
+    }
+    return result;
+}
+
+template <typename Weight>
+transport_catalog_serialize::HubLabels HubLabels<Weight>::GetSerializeData() const {
+    transport_catalog_serialize::HubLabels data_out;
+    data_out.mutable_out_offsets()->Add(out_.offsets.begin(), out_.offsets.end());
+    data_out.mutable_out_hubs()->Add(out_.hubs.begin(), out_.hubs.end());
+    StoreWeights(out_.weights, data_out.mutable_out_weights(), data_out.mutable_out_float_weights());
+    data_out.mutable_in_offsets()->Add(in_.offsets.begin(), in_.offsets.end());
+    data_out.mutable_in_hubs()->Add(in_.hubs.begin(), in_.hubs.end());
+    StoreWeights(in_.weights, data_out.mutable_in_weights(), data_out.mutable_in_float_weights());
+    return data_out;
+}
+
+template <typename Weight>
+std::optional<Weight> HubLabels<Weight>::GetWeight(VertexId from, VertexId to) const {
+    if (from >= graph_.GetVertexCount() || to >= graph_.GetVertexCount()) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    std::optional<Weight> result;
+    uint32_t out_index = out_.offsets[from];
+    uint32_t in_index = in_.offsets[to];
+    while (out_index < out_.offsets[from + 1] && in_index < in_.offsets[to + 1]) {
+        if (out_.hubs[out_index] < in_.hubs[in_index]) {
+            ++out_index;
+        } else if (in_.hubs[in_index] < out_.hubs[out_index]) {
+            ++in_index;
+        } else {
+            const Weight weight = out_.weights[out_index++] + in_.weights[in_index++];
+            if (!result || weight < *result) {
+                result = weight;
+            }
+        }
+    }
+    return result;
+}
+
+template <typename Weight>
+std::optional<typename HubLabels<Weight>::RouteInfo> HubLabels<Weight>::BuildRoute(VertexId from, VertexId to) const {
+    const std::optional<Weight> weight = GetWeight(from, to);
+    if (!weight) {
+        return std::nullopt;
+    }
+    if (++route_current_ == 0) {
+        std::fill(route_epoch_.begin(), route_epoch_.end(), 0);
+        route_current_ = 1;
+    }
+    //оценка согласована (точный вес остатка), поэтому первое извлечение to даёт кратчайший путь;
+    //при погрешности float вершина может быть улучшена и после извлечения — тогда она раскрывается снова
+    Queue queue;
+    route_epoch_[from] = route_current_;
+    route_vertices_[from] = {ZERO_WEIGHT, weight, NO_EDGE};
+    queue.push({*weight, from});
+    while (!queue.empty()) {
+        const auto [estimate, vertex] = queue.top();
+        queue.pop();
+        const RouteVertex& current = route_vertices_[vertex];
+        if (estimate > current.weight + *current.rest) {
+            continue;
+        }
+        if (vertex == to) {
+            break;
+        }
+        const Weight vertex_weight = current.weight;
+        for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+            const auto edge = graph_.GetEdge(edge_id);
+            const Weight candidate_weight = vertex_weight + edge.weight;
+            RouteVertex& next = route_vertices_[edge.to];
+            if (route_epoch_[edge.to] != route_current_) {
+                route_epoch_[edge.to] = route_current_;
+                next = {candidate_weight, GetWeight(edge.to, to), edge_id};
+            } else if (next.rest && candidate_weight < next.weight) {
+                next.weight = candidate_weight;
+                next.prev_edge = edge_id;
+            } else {
+                continue;
+            }
+            //из вершины без пути до to дальше не идём
+            if (next.rest) {
+                queue.push({candidate_weight + *next.rest, edge.to});
+            }
+        }
+    }
+    if (route_epoch_[to] != route_current_) {
+        throw std::logic_error("Hub labels are inconsistent with the graph");
+    }
+    std::vector<EdgeId> edges;
+    for (VertexId vertex = to; route_vertices_[vertex].prev_edge != NO_EDGE;
+         vertex = graph_.GetEdge(route_vertices_[vertex].prev_edge).from) {
+        edges.push_back(route_vertices_[vertex].prev_edge);
+    }
+    std::reverse(edges.begin(), edges.end());
+    //вес — сумма рёбер найденного пути, как у остальных маршрутизаторов; от веса по меткам
+    //он может отличаться лишь погрешностью округления
+    return RouteInfo{route_vertices_[to].weight, std::move(edges)};
+}
+}
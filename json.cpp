@@ -1,5 +1,29 @@
 #include "json.h"
+#include  <algorithm>
 #include  <cctype>
+#include  <cerrno>
+#include  <charconv>
+#include  <cstdio>
+#include  <cstdlib>
+#include  <memory>
+#include  <numeric>
+#include  <sstream>
+#include  <stdexcept>
+
+//SSE2 есть на любом x86-64; на остальных платформах сканирование скалярное
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define JSON_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+//from_chars/to_chars для double есть не во всех стандартных библиотеках (в libstdc++ — с GCC 11);
+//без них числа с плавающей точкой читаются strtod и печатаются через поток
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+#define JSON_FLOAT_CHARCONV
+#endif
 
 using namespace std;
 
@@ -78,226 +102,546 @@ namespace json {
 	
     
 	namespace{
-	Node LoadNode(istream& input);
 
-	Node LoadNumber(std::istream& input) {
+	constexpr size_t BUFFER_SIZE = size_t(1) << 20;
 
-		std::string parsed_num;
+	//первый блок арены документа; следующие растут геометрически
+	constexpr size_t ARENA_INITIAL_SIZE = size_t(64) << 10;
 
-		// Считывает в parsed_num очередной символ из input
-		auto read_char = [&parsed_num, &input] {
-			parsed_num += static_cast<char>(input.get());
-			if (!input) {
-				throw ParsingError("Failed to read number from stream"s);
-			}
-		};
+	//достаточно для любого int и кратчайшей записи любого double
+	constexpr size_t NUMBER_CHARS = 32;
 
-		// Считывает одну или более цифр в parsed_num из input
-		auto read_digits = [&input, read_char] {
-			if (!isdigit(input.peek())) {
-				throw ParsingError("A digit is expected"s);
-			}
-			while (isdigit(input.peek())) {
-				read_char();
+	Node ParseInt(const char* begin, const char* end) {
+		int value = 0;
+		const auto [ptr, ec] = std::from_chars(begin, end, value);
+		if (ec != std::errc() || ptr != end) {
+			throw ParsingError("Failed to convert "s + std::string(begin, end) + " to number"s);
+		}
+		return Node(value);
+	}
+
+	Node ParseDouble(const char* begin, const char* end) {
+		double value = 0;
+#ifdef JSON_FLOAT_CHARCONV
+		const auto [ptr, ec] = std::from_chars(begin, end, value);
+		const bool parsed = ec == std::errc() && ptr == end;
+#else
+		//strtod нужна строка с нулём в конце; запись числа по грамматике JSON не содержит ничего, кроме цифр,
+		//знаков, точки и экспоненты
+		const std::string number(begin, end);
+		char* parsed_end = nullptr;
+		errno = 0;
+		value = std::strtod(number.c_str(), &parsed_end);
+		const bool parsed = errno != ERANGE && parsed_end == number.c_str() + number.size();
+#endif
+		if (!parsed) {
+			throw ParsingError("Failed to convert "s + std::string(begin, end) + " to number"s);
+		}
+		return Node(value);
+	}
+
+#ifdef JSON_SSE2
+	int CountTrailingZeros(unsigned mask) {
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return static_cast<int>(index);
+#else
+		return __builtin_ctz(mask);
+#endif
+	}
+#endif
+
+	bool IsSpace(char c) {
+		return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+	}
+
+	bool IsStringSpecial(char c) {
+		return c == '"' || c == '\\' || c == '\n' || c == '\r';
+	}
+
+	//первый непробельный символ в [begin, end) или end
+	const char* SkipSpaces(const char* begin, const char* end) {
+#ifdef JSON_SSE2
+		const __m128i space = _mm_set1_epi8(' ');
+		const __m128i lf = _mm_set1_epi8('\n');
+		const __m128i cr = _mm_set1_epi8('\r');
+		const __m128i tab = _mm_set1_epi8('\t');
+		for (; end - begin >= 16; begin += 16) {
+			const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+			const __m128i spaces = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, space), _mm_cmpeq_epi8(chunk, lf)),
+				_mm_or_si128(_mm_cmpeq_epi8(chunk, cr), _mm_cmpeq_epi8(chunk, tab)));
+			const unsigned mask = ~static_cast<unsigned>(_mm_movemask_epi8(spaces)) & 0xFFFFu;
+			if (mask != 0) {
+				return begin + CountTrailingZeros(mask);
 			}
-		};
+		}
+#endif
+		while (begin != end && IsSpace(*begin)) {
+			++begin;
+		}
+		return begin;
+	}
 
-		if (input.peek() == '-') {
-			read_char();
+	//первая кавычка, обратная косая черта или перевод строки в [begin, end) или end
+	const char* FindStringSpecial(const char* begin, const char* end) {
+#ifdef JSON_SSE2
+		const __m128i quote = _mm_set1_epi8('"');
+		const __m128i backslash = _mm_set1_epi8('\\');
+		const __m128i lf = _mm_set1_epi8('\n');
+		const __m128i cr = _mm_set1_epi8('\r');
+		for (; end - begin >= 16; begin += 16) {
+			const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+			const __m128i special = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+				_mm_or_si128(_mm_cmpeq_epi8(chunk, lf), _mm_cmpeq_epi8(chunk, cr)));
+			const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(special));
+			if (mask != 0) {
+				return begin + CountTrailingZeros(mask);
+			}
 		}
-		// Парсим целую часть числа
-		if (input.peek() == '0') {
-			read_char();
-			// После 0 в JSON не могут идти другие цифры
+#endif
+		while (begin != end && !IsStringSpecial(*begin)) {
+			++begin;
 		}
-		else {
-			read_digits();
+		return begin;
+	}
+
+	//Читает вход блоками по BUFFER_SIZE прямо из буфера потока и разбирает их указателями,
+	//без посимвольных get()/peek(). Поток вычитывается дальше конца документа
+	class Parser {
+	public:
+		explicit Parser(istream& input)
+			: input_(*input.rdbuf())
+			, buffer_(new char[BUFFER_SIZE]) {
 		}
 
-		bool is_int = true;
-		// Парсим дробную часть числа
-		if (input.peek() == '.') {
-			read_char();
-			read_digits();
-			is_int = false;
+		void ParseNode(Handler& handler) {
+			if (!SkipToToken()) {
+				handler.Value(Node());
+				return;
+			}
+			const char c = *pos_;
+			if (c == '[') {
+				++pos_;
+				ParseArray(handler);
+			}
+			else if (c == '{') {
+				++pos_;
+				ParseDict(handler);
+			}
+			else if (c == '"') {
+				++pos_;
+				handler.Value(Node(LoadString()));
+			}
+			else if (c == 'n') {
+				LoadLiteral("null"sv);
+				handler.Value(Node());
+			}
+			else if (c == 't') {
+				LoadLiteral("true"sv);
+				handler.Value(Node(true));
+			}
+			else if (c == 'f') {
+				LoadLiteral("false"sv);
+				handler.Value(Node(false));
+			}
+			else {
+				handler.Value(LoadNumber());
+			}
 		}
 
-		// Парсим экспоненциальную часть числа
-		if (int ch = input.peek(); ch == 'e' || ch == 'E') {
-			read_char();
-			if (ch = input.peek(); ch == '+' || ch == '-') {
-				read_char();
+	private:
+		//дочитывает следующий блок; false — вход закончился
+		bool Refill() {
+			if (number_start_) {
+				number_.append(number_start_, end_);
+			}
+			const std::streamsize size = input_.sgetn(buffer_.get(), BUFFER_SIZE);
+			pos_ = buffer_.get();
+			end_ = pos_ + std::max<std::streamsize>(size, 0);
+			if (number_start_) {
+				number_start_ = pos_;
 			}
-			read_digits();
-			is_int = false;
+			return pos_ != end_;
 		}
 
-		try {
-			if (is_int) {
-				return Node(stoi(parsed_num));
+		//пропускает пробелы; false — вход закончился
+		bool SkipToToken() {
+			while (true) {
+				pos_ = SkipSpaces(pos_, end_);
+				if (pos_ != end_) {
+					return true;
+				}
+				if (!Refill()) {
+					return false;
+				}
 			}
-			return Node(stod(parsed_num));
 		}
-		catch (...) {
-			throw ParsingError("Failed to convert "s + parsed_num + " to number"s);
+
+		//следующий непробельный символ (извлекается) или 0 в конце входа
+		char GetToken() {
+			return SkipToToken() ? *pos_++ : '\0';
 		}
-	}
 
-	Node LoadString(std::istream& input) {
-		using namespace std::literals;
+		//очередной символ без извлечения или EOF
+		int Peek() {
+			if (pos_ == end_ && !Refill()) {
+				return EOF;
+			}
+			return static_cast<unsigned char>(*pos_);
+		}
 
-		auto it = std::istreambuf_iterator<char>(input);
-		auto end = std::istreambuf_iterator<char>();
-		std::string s;
-		while (true) {
-			if (it == end) {
-				// Поток закончился до того, как встретили закрывающую кавычку?
-				throw ParsingError("String parsing error");
+		void ParseArray(Handler& handler) {
+			handler.StartArray();
+			char c = GetToken();
+			for (; c != '\0' && c != ']'; c = GetToken()) {
+				if (c != ',') {
+					--pos_;
+				}
+				ParseNode(handler);
 			}
-			const char ch = *it;
-			if (ch == '"') {
-				// Встретили закрывающую кавычку
-				++it;
-				break;
+
+			if (c != ']') {
+				throw ParsingError("] not expected"s);
 			}
-			else if (ch == '\\') {
-				// Встретили начало escape-последовательности
-				++it;
-				if (it == end) {
-					// Поток завершился сразу после символа обратной косой черты
-					throw ParsingError("String parsing error");
+
+			handler.EndArray();
+		}
+
+		void ParseDict(Handler& handler) {
+			handler.StartDict();
+			char c = GetToken();
+			for (; c != '\0' && c != '}'; c = GetToken()) {
+				if (c == ',') {
+					c = GetToken();
 				}
-				const char escaped_char = *(it);
-				// Обрабатываем одну из последовательностей: \\, \n, \t, \r, \"
-				switch (escaped_char) {
-				case 'n':
-					s.push_back('\n');
-					break;
-				case 't':
-					s.push_back('\t');
-					break;
-				case 'r':
-					s.push_back('\r');
-					break;
-				case '"':
-					s.push_back('"');
-					break;
-				case '\\':
-					s.push_back('\\');
-					break;
-				default:
-					// Встретили неизвестную escape-последовательность
-					throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
+				if (c != '"') {
+					throw ParsingError("Dict key expected"s);
+				}
+				handler.Key(LoadString());
+				if (GetToken() != ':') {
+					throw ParsingError(": expected"s);
 				}
+				ParseNode(handler);
 			}
-			else if (ch == '\n' || ch == '\r') {
-				// Строковый литерал внутри- JSON не может прерываться символами \r или \n
-				throw ParsingError("Unexpected end of line"s);
+
+			if (c != '}') {
+				throw ParsingError("} not expected"s);
+			}
+
+			handler.EndDict();
+		}
+
+		void LoadLiteral(std::string_view literal) {
+			for (const char expected : literal) {
+				if (Peek() != static_cast<unsigned char>(expected)) {
+					throw ParsingError("Unexpected value"s);
+				}
+				++pos_;
+			}
+		}
+
+		Node LoadNumber() {
+			// Число разбирается на месте, в number_ копируется только при переходе через границу блока
+			number_.clear();
+			number_start_ = pos_;
+
+			// Пропускает одну или более цифр
+			auto read_digits = [this] {
+				if (!isdigit(Peek())) {
+					throw ParsingError("A digit is expected"s);
+				}
+				while (isdigit(Peek())) {
+					++pos_;
+				}
+			};
+
+			if (Peek() == '-') {
+				++pos_;
+			}
+			// Парсим целую часть числа
+			if (Peek() == '0') {
+				++pos_;
+				// После 0 в JSON не могут идти другие цифры
 			}
 			else {
-				// Просто считываем очередной символ и помещаем его в результирующую строку
-				s.push_back(ch);
+				read_digits();
+			}
+
+			bool is_int = true;
+			// Парсим дробную часть числа
+			if (Peek() == '.') {
+				++pos_;
+				read_digits();
+				is_int = false;
+			}
+
+			// Парсим экспоненциальную часть числа
+			if (int ch = Peek(); ch == 'e' || ch == 'E') {
+				++pos_;
+				if (ch = Peek(); ch == '+' || ch == '-') {
+					++pos_;
+				}
+				read_digits();
+				is_int = false;
+			}
+			const char* begin = number_start_;
+			const char* end = pos_;
+			number_start_ = nullptr;
+			if (!number_.empty()) {
+				number_.append(begin, end);
+				begin = number_.data();
+				end = begin + number_.size();
+			}
+			return is_int ? ParseInt(begin, end) : ParseDouble(begin, end);
+		}
+
+		//строка после открывающей кавычки; обычные символы копируются кусками между спецсимволами
+		std::string LoadString() {
+			std::string s;
+			while (true) {
+				const char* special = FindStringSpecial(pos_, end_);
+				s.append(pos_, special);
+				pos_ = special;
+				if (pos_ == end_) {
+					if (!Refill()) {
+						// Поток закончился до того, как встретили закрывающую кавычку?
+						throw ParsingError("String parsing error");
+					}
+					continue;
+				}
+				const char ch = *pos_++;
+				if (ch == '"') {
+					// Встретили закрывающую кавычку
+					break;
+				}
+				else if (ch == '\\') {
+					// Встретили начало escape-последовательности
+					if (Peek() == EOF) {
+						// Поток завершился сразу после символа обратной косой черты
+						throw ParsingError("String parsing error");
+					}
+					const char escaped_char = *pos_++;
+					// Обрабатываем одну из последовательностей: \\, \n, \t, \r, \"
+					switch (escaped_char) {
+					case 'n':
+						s.push_back('\n');
+						break;
+					case 't':
+						s.push_back('\t');
+						break;
+					case 'r':
+						s.push_back('\r');
+						break;
+					case '"':
+						s.push_back('"');
+						break;
+					case '\\':
+						s.push_back('\\');
+						break;
+					default:
+						// Встретили неизвестную escape-последовательность
+						throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
+					}
+				}
+				else {
+					// Строковый литерал внутри JSON не может прерываться символами \r или \n
+					throw ParsingError("Unexpected end of line"s);
+				}
 			}
-			++it;
+
+			return s;
 		}
 
-		return Node(move(s));
+		std::streambuf& input_;
+		std::unique_ptr<char[]> buffer_;
+		const char* pos_ = nullptr;
+		const char* end_ = nullptr;
+		//начало разбираемого числа в буфере и его часть из предыдущих блоков
+		const char* number_start_ = nullptr;
+		std::string number_;
+	};
+
+}  // namespace
+
+//---------------------------------Dict----------------------------------------
+
+	namespace {
+	constexpr size_t SMALL_DICT_SIZE = 16;
+
+	bool KeyLess(const Dict::value_type& item, std::string_view key) {
+		return std::string_view(item.first) < key;
 	}
 
-	Node LoadNull(istream& input) {
-		string s;
-		char c;
-		for (int i = 0; input >> c && i < 4; ++i) {
-			s += c;
+	//Переносит пары из [first, last) в новый вектор точно по размеру, упорядочив по ключу.
+	//Сортируются номера пар, сами пары переносятся один раз; из равных ключей остаётся первый во входе
+	Dict::Items SortedItems(Dict::value_type* first, Dict::value_type* last, std::pmr::memory_resource* resource) {
+		const size_t size = last - first;
+		uint32_t small_order[SMALL_DICT_SIZE];
+		std::vector<uint32_t> large_order;
+		uint32_t* order = small_order;
+		if (size > SMALL_DICT_SIZE) {
+			large_order.resize(size);
+			order = large_order.data();
+		}
+		std::iota(order, order + size, 0u);
+		const auto less = [first](uint32_t lhs, uint32_t rhs) {
+			return first[lhs].first < first[rhs].first;
+		};
+		if (size <= SMALL_DICT_SIZE) {
+			//вставками: без выделения памяти, которое делает stable_sort
+			for (size_t i = 1; i < size; ++i) {
+				std::rotate(std::upper_bound(order, order + i, order[i], less), order + i, order + i + 1);
+			}
+		}
+		else {
+			std::stable_sort(order, order + size, less);
 		}
-		if (s != "null"s) {
-			throw ParsingError("Unexpected value"s);
+
+		Dict::Items items(resource);
+		items.reserve(size);
+		for (size_t i = 0; i < size; ++i) {
+			Dict::value_type& item = first[order[i]];
+			if (items.empty() || items.back().first != item.first) {
+				items.push_back(move(item));
+			}
 		}
-		return Node();
+		return items;
+	}
+
+	bool IsSorted(const Dict::Items& items) {
+		return std::adjacent_find(items.begin(), items.end(), [](const Dict::value_type& lhs, const Dict::value_type& rhs) {
+			return !(lhs.first < rhs.first);
+		}) == items.end();
+	}
 	}
 
-	Node LoadBool(istream& input) {
-		string s;
-		char c;
+	//items_ перемещается, а не присваивается: так вектор сохраняет ресурс items
+	Dict::Dict(Items items)
+		: items_(IsSorted(items) ? move(items)
+			: SortedItems(items.data(), items.data() + items.size(), items.get_allocator().resource())) {
+	}
 
-		for (; input >> c && s.size() < 5 && c != 'e'; s += c);
-		s += c;
+	Dict::Dict(std::initializer_list<value_type> items)
+		: Dict(Items(items)) {
+	}
 
-		if (s == "true"s) {
-			return Node(true);
-		}
-		if (s == "false"s) {
-			return Node(false);
+	Dict::iterator Dict::find(std::string_view key) {
+		const auto it = std::lower_bound(items_.begin(), items_.end(), key, KeyLess);
+		return it != items_.end() && it->first == key ? it : items_.end();
+	}
+
+	Dict::const_iterator Dict::find(std::string_view key) const {
+		const auto it = std::lower_bound(items_.begin(), items_.end(), key, KeyLess);
+		return it != items_.end() && it->first == key ? it : items_.end();
+	}
+
+	Node& Dict::at(std::string_view key) {
+		const auto it = find(key);
+		if (it == items_.end()) {
+			throw std::out_of_range("No key "s + std::string(key));
 		}
-		throw ParsingError("Unexpected value"s);
+		return it->second;
 	}
 
-	Node LoadArray(istream& input) {
-		Array result;
-		char c;
-		for (; input >> c && c != ']';) {
-			if (c != ',') {
-				input.putback(c);
-			}
-			result.push_back(move(LoadNode(input)));
+	const Node& Dict::at(std::string_view key) const {
+		const auto it = find(key);
+		if (it == items_.end()) {
+			throw std::out_of_range("No key "s + std::string(key));
 		}
+		return it->second;
+	}
 
-		if (c != ']') {
-			throw ParsingError("] not expected"s);
+	std::pair<Dict::iterator, bool> Dict::insert(value_type item) {
+		//ключи обычно идут по порядку: тогда вставка — в конец
+		if (items_.empty() || items_.back().first < item.first) {
+			items_.push_back(move(item));
+			return { items_.end() - 1, true };
 		}
+		const auto it = std::lower_bound(items_.begin(), items_.end(), item.first, KeyLess);
+		if (it != items_.end() && it->first == item.first) {
+			return { it, false };
+		}
+		return { items_.insert(it, move(item)), true };
+	}
 
-		return Node(move(result));
+	std::pair<Dict::iterator, bool> Dict::emplace(std::string key, Node value) {
+		return insert({ move(key), move(value) });
 	}
 
-	Node LoadDict(istream& input) {
-		Dict result;
-		char c;
-		for (; input >> c && c != '}';) {
-			if (c == ',') {
-				input >> c;
-			}
+//---------------------------------TreeHandler---------------------------------
 
-			string key = LoadString(input).AsString();
-			input >> c;
-			result.insert({ move(key), LoadNode(input) });
+	TreeHandler::Level& TreeHandler::PushLevel(bool is_array) {
+		if (depth_ == stack_.size()) {
+			stack_.emplace_back();
 		}
+		Level& level = stack_[depth_++];
+		level.is_array = is_array;
+		return level;
+	}
+
+	void TreeHandler::StartDict() {
+		PushLevel(false);
+	}
 
-		if (c != '}') {
-			throw ParsingError("} not expected"s);
+	void TreeHandler::Key(std::string key) {
+		if (depth_ == 0 || stack_[depth_ - 1].is_array) {
+			throw ParsingError("Key outside of a dict"s);
 		}
+		stack_[depth_ - 1].key = move(key);
+	}
 
-		return Node(move(result));
+	void TreeHandler::EndDict() {
+		if (depth_ == 0 || stack_[depth_ - 1].is_array) {
+			throw ParsingError("Unexpected end of dict"s);
+		}
+		auto& items = stack_[depth_ - 1].items;
+		Node node(Dict(SortedItems(items.data(), items.data() + items.size(), resource_)));
+		items.clear();
+		--depth_;
+		AddNode(move(node));
 	}
 
-	Node LoadNode(istream& input) {
-		char c;
-		if (input >> c) {
-			if (c == '[') {
-				return LoadArray(input);
-			}
-			else if (c == '{') {
-				return LoadDict(input);
-			}
-			else if (c == '"') {
-				return LoadString(input);
-			}
-			else if (c == 'n') {
-				input.putback(c);
-				return LoadNull(input);
-			}
-			else if (c == 't' || c == 'f') {
-				input.putback(c);
-				return LoadBool(input);
-			}
-			else {
-				input.putback(c);
-				return LoadNumber(input);
-			}
+	void TreeHandler::StartArray() {
+		PushLevel(true);
+	}
+
+	void TreeHandler::EndArray() {
+		if (depth_ == 0 || !stack_[depth_ - 1].is_array) {
+			throw ParsingError("Unexpected end of array"s);
 		}
-		else return {};
+		Array& array = stack_[depth_ - 1].array;
+		Node node(Array(make_move_iterator(array.begin()), make_move_iterator(array.end()), resource_));
+		array.clear();
+		--depth_;
+		AddNode(move(node));
 	}
 
-}  // namespace
+	void TreeHandler::Value(Node value) {
+		AddNode(move(value));
+	}
+
+	Node TreeHandler::Extract() {
+		has_root_ = false;
+		Node root = move(root_);
+		root_ = Node();
+		return root;
+	}
+
+	void TreeHandler::AddNode(Node node) {
+		if (depth_ == 0) {
+			root_ = move(node);
+			has_root_ = true;
+			return;
+		}
+		Level& level = stack_[depth_ - 1];
+		if (level.is_array) {
+			level.array.push_back(move(node));
+		}
+		else {
+			level.items.emplace_back(move(level.key), move(node));
+		}
+	}
 
 //------------------------------------Node-------------------------------------
 
@@ -332,6 +676,74 @@ namespace json {
 		ctx.out << std::boolalpha << value;
 	}
 
+	void PrintValue(int value, const PrintContext& ctx) {
+		char buffer[NUMBER_CHARS];
+		const auto [end, ec] = std::to_chars(buffer, buffer + NUMBER_CHARS, value);
+		ctx.out.write(buffer, end - buffer);
+	}
+
+	//вид записи — как у потока по умолчанию (%g: без лишних нулей, экспонента при порядке меньше -4
+	//или не меньше точности), точность — 6 знаков, как у потока, или больше, если иначе число
+	//не читается обратно в то же значение. Числа до 6 значащих цифр печатаются так же, как потоком
+	constexpr int DEFAULT_DOUBLE_PRECISION = 6;
+	constexpr int MAX_DOUBLE_PRECISION = 17;
+
+	void PrintValue(double value, const PrintContext& ctx) {
+#ifdef JSON_FLOAT_CHARCONV
+		//кратчайшая научная запись уже совпадает с %g с точностью по числу её цифр; если %g выбрал бы
+		//обычную запись, она собирается из цифр мантиссы и порядка (второй вызов to_chars с точностью
+		//вдвое медленнее)
+		char buffer[NUMBER_CHARS];
+		char* const end = std::to_chars(buffer, buffer + NUMBER_CHARS, value, std::chars_format::scientific).ptr;
+		char* const exponent_begin = std::find(buffer, end, 'e');
+		if (exponent_begin == end) {
+			ctx.out.write(buffer, end - buffer);	//inf, nan
+			return;
+		}
+		int exponent = 0;
+		std::from_chars(exponent_begin + (exponent_begin[1] == '+' ? 2 : 1), end, exponent);
+		char* const digits_begin = buffer[0] == '-' ? buffer + 1 : buffer;
+		char digits[MAX_DOUBLE_PRECISION];
+		int digit_count = 0;
+		for (const char* it = digits_begin; it != exponent_begin; ++it) {
+			if (*it != '.') {
+				digits[digit_count++] = *it;
+			}
+		}
+		if (exponent < -4 || exponent >= std::max(digit_count, DEFAULT_DOUBLE_PRECISION)) {
+			ctx.out.write(buffer, end - buffer);
+			return;
+		}
+		char fixed[NUMBER_CHARS];
+		char* out = std::copy(buffer, digits_begin, fixed);
+		if (exponent < 0) {
+			out = std::fill_n(std::copy_n("0.", 2, out), -exponent - 1, '0');
+			out = std::copy_n(digits, digit_count, out);
+		} else {
+			const int integer_digits = std::min(digit_count, exponent + 1);
+			out = std::copy_n(digits, integer_digits, out);
+			out = std::fill_n(out, exponent + 1 - integer_digits, '0');
+			if (digit_count > integer_digits) {
+				*out++ = '.';
+				out = std::copy_n(digits + integer_digits, digit_count - integer_digits, out);
+			}
+		}
+		ctx.out.write(fixed, out - fixed);
+#else
+		std::ostringstream stream;
+		stream.imbue(std::locale::classic());
+		for (int precision = DEFAULT_DOUBLE_PRECISION; ; ++precision) {
+			stream.str({});
+			stream.precision(precision);
+			stream << value;
+			if (precision == MAX_DOUBLE_PRECISION || std::strtod(stream.str().c_str(), nullptr) == value) {
+				break;
+			}
+		}
+		ctx.out << stream.str();
+#endif
+	}
+
 	void PrintString(const std::string& value, const PrintContext& ctx) {
 		//  \n, \r, \", \t, \\.
 		ctx.out << '"';
@@ -365,7 +777,7 @@ namespace json {
 		PrintString(value, ctx);
 	}
 
-	void PrintValue(Array nodes, const PrintContext& ctx) {
+	void PrintValue(const Array& nodes, const PrintContext& ctx) {
 		std::ostream& out = ctx.out;
 		out << "[\n"sv;
 		bool flag = true;
@@ -385,7 +797,7 @@ namespace json {
 		out.put(']');
 	}
 
-	[[maybe_unused]] void PrintValue(Dict nodes, const PrintContext& ctx) {
+	[[maybe_unused]] void PrintValue(const Dict& nodes, const PrintContext& ctx) {
 		std::ostream& out = ctx.out;
 		out << "{\n"sv;
 		bool flag = true;
@@ -426,6 +838,9 @@ namespace json {
 	}
 
 	Document& Document::operator= (Document&& other) {
+		//старое дерево разрушается до смены арены: иначе узлы other переносились бы в освобождаемую арену
+		root_ = Node();
+		arena_ = move(other.arena_);
 		root_ = move(other.root_);
 		return *this;
 	}
@@ -446,12 +861,29 @@ namespace json {
 		: root_(move(root)) {
 	}
 
+	Document::Document(std::unique_ptr<std::pmr::memory_resource> arena, Node root)
+		: arena_(move(arena))
+		, root_(move(root)) {
+	}
+
 	const Node& Document::GetRoot() const {
 		return root_;
 	}
 
-	Document Load(istream& input) {
-		return Document{ LoadNode(input) };
+	void Parse(istream& input, Handler& handler) {
+		Parser(input).ParseNode(handler);
+	}
+
+	Document Load(istream& input, bool use_arena) {
+		if (!use_arena) {
+			TreeHandler handler;
+			Parse(input, handler);
+			return Document{ handler.Extract() };
+		}
+		auto arena = std::make_unique<std::pmr::monotonic_buffer_resource>(ARENA_INITIAL_SIZE);
+		TreeHandler handler(arena.get());
+		Parse(input, handler);
+		return Document(move(arena), handler.Extract());
 	}
 
 	void Print(const Document& doc, std::ostream& output) {
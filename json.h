@@ -1,6 +1,8 @@
 #pragma once
+#include <initializer_list>
 #include <iostream>
-#include <map>
+#include <memory>
+#include <memory_resource>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -12,9 +14,47 @@ using namespace std::string_view_literals;
 namespace json {
 
 	class Node;
-	// Сохраните объявления Dict и Array без изменения
-	using Dict = std::map<std::string, Node>;
-	using Array = std::vector<Node>;
+	//Массивы и словари выделяют память через memory_resource: по умолчанию из кучи,
+	//в документе из Load(input, true) — из его арены
+	using Array = std::pmr::vector<Node>;
+
+	// Словарь: пары ключ-значение в одном векторе, упорядоченном по ключу. Поиск двоичный по string_view,
+	// без временных строк; обход, как у std::map, в порядке ключей. При повторе ключа остаётся первое значение
+	class Dict {
+	public:
+		using value_type = std::pair<std::string, Node>;
+		using Items = std::pmr::vector<value_type>;
+		using iterator = Items::iterator;
+		using const_iterator = Items::const_iterator;
+
+		Dict() = default;
+		//пары в любом порядке; память — из ресурса items
+		explicit Dict(Items items);
+		Dict(std::initializer_list<value_type> items);
+
+		[[nodiscard]] size_t size() const;
+		[[nodiscard]] bool empty() const;
+		iterator begin();
+		iterator end();
+		const_iterator begin() const;
+		const_iterator end() const;
+
+		iterator find(std::string_view key);
+		const_iterator find(std::string_view key) const;
+		size_t count(std::string_view key) const;
+		//std::out_of_range, если ключа нет
+		Node& at(std::string_view key);
+		const Node& at(std::string_view key) const;
+
+		std::pair<iterator, bool> insert(value_type item);
+		std::pair<iterator, bool> emplace(std::string key, Node value);
+
+		bool operator==(const Dict& other) const;
+		bool operator!=(const Dict& other) const;
+
+	private:
+		Items items_;
+	};
 
 	// Эта ошибка должна выбрасываться при ошибках парсинга JSON
 	class ParsingError : public std::runtime_error {
@@ -66,10 +106,22 @@ namespace json {
 		Value value_;
 	};
 
+	inline size_t Dict::size() const { return items_.size(); }
+	inline bool Dict::empty() const { return items_.empty(); }
+	inline Dict::iterator Dict::begin() { return items_.begin(); }
+	inline Dict::iterator Dict::end() { return items_.end(); }
+	inline Dict::const_iterator Dict::begin() const { return items_.begin(); }
+	inline Dict::const_iterator Dict::end() const { return items_.end(); }
+	inline size_t Dict::count(std::string_view key) const { return find(key) != end() ? 1 : 0; }
+	inline bool Dict::operator==(const Dict& other) const { return items_ == other.items_; }
+	inline bool Dict::operator!=(const Dict& other) const { return !(*this == other); }
+
 	class Document {
 	public:
 		Document() = default;
 		explicit Document(Node root);
+		//дерево, выделенное из arena: арена живёт, пока жив документ, и освобождается целиком
+		Document(std::unique_ptr<std::pmr::memory_resource> arena, Node root);
 		const Node& GetRoot() const ;
 
 		Document& operator= (Document& other);
@@ -81,10 +133,70 @@ namespace json {
 		bool operator!=(const Document& lhs) const;
 
 	private:
+		//объявлена до root_: дерево разрушается раньше арены
+		std::unique_ptr<std::pmr::memory_resource> arena_;
 		Node root_ = {};
 	};
 
-	Document Load(std::istream& input);
+	// Обработчик потокового разбора: парсер сообщает о каждом элементе по мере чтения,
+	// дерево Node при этом не строится
+	class Handler {
+	public:
+		virtual ~Handler() = default;
+		virtual void StartDict() = 0;
+		virtual void Key(std::string key) = 0;
+		virtual void EndDict() = 0;
+		virtual void StartArray() = 0;
+		virtual void EndArray() = 0;
+		//null, bool, int, double или строка
+		virtual void Value(Node value) = 0;
+	};
+
+	// Собирает дерево Node из событий разбора
+	class TreeHandler final : public Handler {
+	public:
+		//массивы и словари дерева выделяются из resource
+		explicit TreeHandler(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+			: resource_(resource) {
+		}
+
+		void StartDict() override;
+		void Key(std::string key) override;
+		void EndDict() override;
+		void StartArray() override;
+		void EndArray() override;
+		void Value(Node value) override;
+
+		//корневое значение получено целиком
+		[[nodiscard]] bool IsComplete() const { return has_root_ && depth_ == 0; }
+		Node Extract();
+
+	private:
+		void AddNode(Node node);
+
+		//уровни не удаляются, а переиспользуются: их буферы сохраняют ёмкость, и готовый контейнер
+		//выделяется один раз точно по размеру
+		struct Level {
+			bool is_array = false;
+			Array array;
+			std::vector<Dict::value_type> items;
+			std::string key;
+		};
+		Level& PushLevel(bool is_array);
+
+		std::pmr::memory_resource* resource_;
+		std::vector<Level> stack_;
+		size_t depth_ = 0;
+		Node root_;
+		bool has_root_ = false;
+	};
+
+	// Потоковый разбор: элементы документа передаются в handler
+	void Parse(std::istream& input, Handler& handler);
+
+	//use_arena — дерево выделяется из арены (monotonic_buffer_resource), которой владеет документ:
+	//память берётся крупными блоками и освобождается разом вместе с документом
+	Document Load(std::istream& input, bool use_arena = false);
 
 	void Print(const Document& doc, std::ostream& output);
 
@@ -4,17 +4,17 @@
 
 using namespace json_reader;
 
-const std::vector<domain::BusInput> JsonReader::GetBuses() const
+const std::vector<domain::BusInput>& JsonReader::GetBuses() const
 {
     return buses_;
 }
 
-const std::vector<domain::StopInput> JsonReader::GetStops() const
+const std::vector<domain::StopInput>& JsonReader::GetStops() const
 {
     return stops_;
 }
 
-const std::map<std::pair<std::string, std::string>, int> JsonReader::GetDistances() const
+const std::vector<domain::DistanceInput>& JsonReader::GetDistances() const
 {
     return distances_;
 }
@@ -24,9 +24,293 @@ const std::vector<domain::query> json_reader::JsonReader::GetQuery() const
     return stats_;
 }
 
-void JsonReader::LoadDocument(std::istream &input)
+//Состояния разбора: ROOT — ключи корневого словаря, SECTION — раздел, собираемый в дерево Node,
+//BASE_REQUESTS — массив base_requests, REQUEST — поля одного запроса, DISTANCES и STOPS —
+//road_distances и stops запроса, SKIP — пропуск незнакомого поля запроса
+class JsonReader::InputHandler final : public json::Handler {
+public:
+    //разделы документа собираются в arena
+    InputHandler(JsonReader& reader, bool add_stops, std::pmr::memory_resource* arena)
+        : reader_(reader), add_stops_(add_stops), section_(arena) {}
+
+    void StartDict() override {
+        switch (state_) {
+        case State::START:
+            state_ = State::ROOT;
+            break;
+        case State::ROOT:
+            if (key_ == "base_requests"s) {
+                throw std::logic_error("Not an array"s);
+            }
+            StartSection();
+            section_.StartDict();
+            break;
+        case State::SECTION:
+            section_.StartDict();
+            ++depth_;
+            break;
+        case State::BASE_REQUESTS:
+            request_ = {};
+            state_ = State::REQUEST;
+            break;
+        case State::REQUEST:
+            if (field_ == "road_distances"s) {
+                state_ = State::DISTANCES;
+            } else {
+                StartSkip();
+            }
+            break;
+        case State::SKIP:
+            ++depth_;
+            break;
+        default:
+            throw std::invalid_argument("invalid base_requests: unexpected dict"s);
+        }
+    }
+
+    void Key(std::string key) override {
+        switch (state_) {
+        case State::ROOT:
+            key_ = std::move(key);
+            break;
+        case State::SECTION:
+            section_.Key(std::move(key));
+            break;
+        case State::REQUEST:
+            field_ = std::move(key);
+            break;
+        case State::DISTANCES:
+            field_ = std::move(key);
+            break;
+        default:
+            break;
+        }
+    }
+
+    void EndDict() override {
+        switch (state_) {
+        case State::ROOT:
+            state_ = State::END;
+            break;
+        case State::SECTION:
+            section_.EndDict();
+            EndNested();
+            break;
+        case State::REQUEST:
+            AddRequest();
+            state_ = State::BASE_REQUESTS;
+            break;
+        case State::DISTANCES:
+            state_ = State::REQUEST;
+            break;
+        case State::SKIP:
+            EndNested();
+            break;
+        default:
+            break;
+        }
+    }
+
+    void StartArray() override {
+        switch (state_) {
+        case State::START:
+            throw std::logic_error("Not a dict"s);
+        case State::ROOT:
+            if (key_ == "base_requests"s) {
+                state_ = State::BASE_REQUESTS;
+            } else {
+                StartSection();
+                section_.StartArray();
+            }
+            break;
+        case State::SECTION:
+            section_.StartArray();
+            ++depth_;
+            break;
+        case State::REQUEST:
+            if (field_ == "stops"s) {
+                request_.has_stops = true;
+                state_ = State::STOPS;
+            } else {
+                StartSkip();
+            }
+            break;
+        case State::SKIP:
+            ++depth_;
+            break;
+        default:
+            throw std::invalid_argument("invalid base_requests: unexpected array"s);
+        }
+    }
+
+    void EndArray() override {
+        switch (state_) {
+        case State::SECTION:
+            section_.EndArray();
+            EndNested();
+            break;
+        case State::BASE_REQUESTS:
+            state_ = State::ROOT;
+            break;
+        case State::STOPS:
+            state_ = State::REQUEST;
+            break;
+        case State::SKIP:
+            EndNested();
+            break;
+        default:
+            break;
+        }
+    }
+
+    void Value(json::Node value) override {
+        switch (state_) {
+        case State::START:
+            if (!value.IsNull()) {
+                throw std::logic_error("Not a dict"s);
+            }
+            break;
+        case State::ROOT:
+            if (key_ == "base_requests"s) {
+                throw std::logic_error("Not an array"s);
+            }
+            sections_.insert({ std::move(key_), std::move(value) });
+            break;
+        case State::SECTION:
+            section_.Value(std::move(value));
+            break;
+        case State::BASE_REQUESTS:
+            throw std::logic_error("Not a dict"s);
+        case State::REQUEST:
+            SetField(std::move(value));
+            break;
+        case State::DISTANCES:
+            request_.distances.push_back({ reader_.AddName(std::move(field_)), value.AsInt() });
+            break;
+        case State::STOPS:
+            if (value.IsString()) {
+                request_.stops.push_back(reader_.AddName(value.AsString()));
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    //разделы документа, кроме base_requests
+    json::Dict ExtractSections() {
+        return std::move(sections_);
+    }
+
+private:
+    enum class State { START, ROOT, SECTION, BASE_REQUESTS, REQUEST, DISTANCES, STOPS, SKIP, END };
+
+    //поля запроса base_requests, известные до конца его словаря
+    struct Request {
+        std::optional<std::string> type;
+        std::optional<std::string> name;
+        std::optional<double> latitude;
+        std::optional<double> longitude;
+        std::optional<bool> is_roundtrip;
+        bool has_stops = false;
+        std::vector<std::string_view> stops;
+        std::vector<std::pair<std::string_view, int>> distances;
+    };
+
+    void StartSection() {
+        depth_ = 1;
+        state_ = State::SECTION;
+    }
+
+    void StartSkip() {
+        depth_ = 1;
+        state_ = State::SKIP;
+    }
+
+    void EndNested() {
+        if (--depth_ > 0) {
+            return;
+        }
+        if (state_ == State::SECTION) {
+            sections_.insert({ std::move(key_), section_.Extract() });
+            state_ = State::ROOT;
+        } else {
+            state_ = State::REQUEST;
+        }
+    }
+
+    void SetField(json::Node value) {
+        if (field_ == "type"s) {
+            request_.type = value.AsString();
+        } else if (field_ == "name"s) {
+            request_.name = value.AsString();
+        } else if (field_ == "latitude"s) {
+            request_.latitude = value.AsDouble();
+        } else if (field_ == "longitude"s) {
+            request_.longitude = value.AsDouble();
+        } else if (field_ == "is_roundtrip"s) {
+            request_.is_roundtrip = value.AsBool();
+        } else if (field_ == "stops"s) {
+            throw std::logic_error("Not an array"s);
+        } else if (field_ == "road_distances"s) {
+            throw std::logic_error("Not a dict"s);
+        }
+    }
+
+    void AddRequest() {
+        if (!request_.type) {
+            throw std::invalid_argument("invalid base_requests: no type"s);
+        }
+        if (*request_.type == "Stop"s) {
+            if (!request_.name || !request_.latitude || !request_.longitude) {
+                throw std::invalid_argument("invalid base_requests: Stop without name or coordinates"s);
+            }
+            const std::string_view name = reader_.AddName(std::move(*request_.name));
+            if (add_stops_) {
+                reader_.catalogue_.AddStop(name, { *request_.latitude, *request_.longitude });
+            } else {
+                reader_.stops_.push_back({ std::string(name), { *request_.latitude, *request_.longitude } });
+            }
+            for (const auto& [to, distance] : request_.distances) {
+                reader_.distances_.push_back({ name, to, distance });
+            }
+        }
+        else if (*request_.type == "Bus"s) {
+            if (!request_.name || !request_.is_roundtrip || !request_.has_stops) {
+                throw std::invalid_argument("invalid base_requests: Bus without name, is_roundtrip or stops"s);
+            }
+            reader_.buses_.push_back({ std::move(*request_.name), std::move(request_.stops), *request_.is_roundtrip });
+        }
+        else {
+            throw std::invalid_argument("Unknown type"s);
+        }
+    }
+
+    JsonReader& reader_;
+    const bool add_stops_;
+    State state_ = State::START;
+    //текущий ключ корневого словаря и текущее поле запроса (или остановка road_distances)
+    std::string key_;
+    std::string field_;
+    Request request_;
+    json::TreeHandler section_;
+    //вложенность внутри SECTION или SKIP
+    size_t depth_ = 0;
+    json::Dict sections_;
+};
+
+void JsonReader::LoadDocument(std::istream &input, bool add_stops)
+{
+    //stat_requests и настройки живут до конца работы, поэтому их дерево выделяется из арены документа
+    auto arena = std::make_unique<std::pmr::monotonic_buffer_resource>();
+    InputHandler handler(*this, add_stops, arena.get());
+    json::Parse(input, handler);
+    document_ = json::Document(std::move(arena), json::Node(handler.ExtractSections()));
+}
+
+std::string_view JsonReader::AddName(std::string name)
 {
-    document_ = json::Load(input);
+    return *names_.insert(std::move(name)).first;
 }
 
 void JsonReader::ReadDocument()
@@ -36,27 +320,33 @@ void JsonReader::ReadDocument()
 
     auto& it = document_.GetRoot().AsMap();
 
-    if (it.count("base_requests"s))
-    {
-        ParseBase(it.at("base_requests"s));
-    }
-    if (it.count("stat_requests"s) && it.at("stat_requests"s).IsArray())
+    if (it.count("stat_requests"sv) && it.at("stat_requests"sv).IsArray())
     {
-        ParseStats(it.at("stat_requests"s));
+        ParseStats(it.at("stat_requests"sv));
     }
-    if (it.count("render_settings"s))
+    if (it.count("render_settings"sv))
     {
-        ParseSettings(it.at("render_settings"s));
+        ParseSettings(it.at("render_settings"sv));
     }
-    if (it.count("routing_settings"s)) {
-        ParseRoutingSettings(it.at("routing_settings"s));
+    if (it.count("routing_settings"sv)) {
+        ParseRoutingSettings(it.at("routing_settings"sv));
     }
-    if (it.count ("serialization_settings"s)) {
+    if (it.count("serialization_settings"sv)) {
 
-        
-        const std::filesystem::path  path = it.at("serialization_settings"s)
-                .AsMap().at ("file"s).AsString();
+        const json::Dict& serialization_settings = it.at("serialization_settings"sv).AsMap();
+        const std::filesystem::path  path = serialization_settings.at("file"sv).AsString();
         serializator_.SetPathToSerialize(path);
+        //формат записываемого снапшота; читается снапшот любого формата
+        if (serialization_settings.count("format"sv)) {
+            const std::string& format = serialization_settings.at("format"sv).AsString();
+            if (format == "protobuf"s) {
+                serializator_.SetFormat(serialize::SnapshotFormat::PROTOBUF);
+            } else if (format == "flat"s) {
+                serializator_.SetFormat(serialize::SnapshotFormat::FLAT);
+            } else {
+                throw std::invalid_argument("invalid serialization_settings: unknown format "s + format);
+            }
+        }
     }
 }
 
@@ -71,68 +361,55 @@ void JsonReader::PrintDocument(json::Document& document_answer, json::Builder& b
     document_answer = builder.Build();
 }
 
-void JsonReader::ParseBase(const json::Node& node_)
-{
-    auto& nodes = node_.AsArray();
-    for (auto& node : nodes) {
-        auto& tag = node.AsMap();
-        if (tag.at("type"s).AsString() == "Stop"s)
-        {
-            const auto name_ = tag.at("name"s).AsString();
-            double lat = tag.at("latitude"s).AsDouble();
-            double lng = tag.at("longitude"s).AsDouble();
-            stops_.push_back({ name_, lat, lng });
-
-            //дистанция
-            if (tag.count("road_distances"s)) {
-                auto& distances = tag.at("road_distances"s).AsMap();
-                for (const auto&[name, value] : distances) {
-                    distances_[{name_, name}] = value.AsInt();
-                }
-            }
-        }
-        else if (tag.at("type"s).AsString() == "Bus"s)
-        {
-            const auto name = tag.at("name"s).AsString();
-            const auto round = tag.at("is_roundtrip"s).AsBool();
-            auto& it = tag.at("stops"s).AsArray();
-
-            std::vector<std::string_view> stops_;
-            stops_.reserve(it.size());
-
-            for (const auto &stop : it) {
-                if (stop.IsString()) {
-                    stops_.push_back(stop.AsString());
-                }
-            }
-            buses_.push_back({ name,stops_,round });
-        }
-        else {
-            throw std::invalid_argument("Unknown type"s);
-        }
-    }
-}
-
 void JsonReader::ParseStats(const json::Node& node_)
 {
     auto& nodes = node_.AsArray();
     for (auto& node : nodes) {
         const auto& tag = node.AsMap();
-        const auto& type = tag.at("type"s).AsString();
+        const auto& type = tag.at("type"sv).AsString();
         //{id,type,name}
         if (type == "Stop"s || type == "Bus"s)
         {
-            stats_.push_back({ tag.at("id"s).AsInt(), type, tag.at("name"s).AsString(),""s,""s });
+            stats_.push_back({ tag.at("id"sv).AsInt(), type, tag.at("name"sv).AsString(),""s,""s });
         }
         else if (type == "Map"s)
         {
             //{ "id": 1, "type": "Map" },
-            stats_.push_back({ tag.at("id"s).AsInt(), type, type,""s,""s });
+            stats_.push_back({ tag.at("id"sv).AsInt(), type, type,""s,""s });
         }
         else if (type == "Route"s)
         {
             //{"id" : 4,"type": "Route",  "from" : "Biryulyovo Zapadnoye","to" : "Universam",}
-            stats_.push_back({ tag.at("id"s).AsInt(), type,  type, tag.at("from"s).AsString(), tag.at("to"s).AsString() });
+            stats_.push_back({ tag.at("id"sv).AsInt(), type,  type, tag.at("from"sv).AsString(), tag.at("to"sv).AsString() });
+        }
+        else if (type == "RouteMatrix"s)
+        {
+            //{"id": 5, "type": "RouteMatrix", "sources": ["A", "B"], "targets": ["C", "D", "E"]}
+            domain::query stat;
+            stat.id = tag.at("id"sv).AsInt();
+            stat.type = type;
+            stat.name = type;
+            for (const auto& stop : tag.at("sources"sv).AsArray()) {
+                stat.sources.push_back(stop.AsString());
+            }
+            for (const auto& stop : tag.at("targets"sv).AsArray()) {
+                stat.targets.push_back(stop.AsString());
+            }
+            stats_.push_back(std::move(stat));
+        }
+        else if (type == "Isochrone"s)
+        {
+            //{"id": 6, "type": "Isochrone", "from": "A", "time_limit": 30}
+            domain::query stat;
+            stat.id = tag.at("id"sv).AsInt();
+            stat.type = type;
+            stat.name = type;
+            stat.from = tag.at("from"sv).AsString();
+            stat.time_limit = tag.at("time_limit"sv).AsDouble();
+            if (stat.time_limit < 0) {
+                throw std::invalid_argument("invalid Isochrone: time_limit < 0"s);
+            }
+            stats_.push_back(std::move(stat));
         }
         else {
             throw std::invalid_argument("Unknown type"s);
@@ -146,45 +423,45 @@ void JsonReader::ParseSettings(const json::Node& node_)
 
     auto& settings = node_.AsMap();
 
-    if (settings.count("width"s)) {
-        render_settings.width = settings.at("width"s).AsDouble();
+    if (settings.count("width"sv)) {
+        render_settings.width = settings.at("width"sv).AsDouble();
     }
-    if (settings.count("height"s)) {
-        render_settings.height = settings.at("height"s).AsDouble();
+    if (settings.count("height"sv)) {
+        render_settings.height = settings.at("height"sv).AsDouble();
     }
-    if (settings.count("padding"s)) {
-        render_settings.padding = settings.at("padding"s).AsDouble();
+    if (settings.count("padding"sv)) {
+        render_settings.padding = settings.at("padding"sv).AsDouble();
     }
-    if (settings.count("line_width"s)) {
-        render_settings.line_width = settings.at("line_width"s).AsDouble();
+    if (settings.count("line_width"sv)) {
+        render_settings.line_width = settings.at("line_width"sv).AsDouble();
     }
-    if (settings.count("stop_radius"s)) {
-        render_settings.stop_radius = settings.at("stop_radius"s).AsDouble();
+    if (settings.count("stop_radius"sv)) {
+        render_settings.stop_radius = settings.at("stop_radius"sv).AsDouble();
     }
-    if (settings.count("bus_label_font_size"s)) {
-        render_settings.bus_label_font_size = settings.at("bus_label_font_size"s).AsDouble();
+    if (settings.count("bus_label_font_size"sv)) {
+        render_settings.bus_label_font_size = settings.at("bus_label_font_size"sv).AsDouble();
     }
-    if (settings.count("bus_label_offset"s)) {
-        auto it = settings.at("bus_label_offset"s).AsArray();
+    if (settings.count("bus_label_offset"sv)) {
+        auto it = settings.at("bus_label_offset"sv).AsArray();
         render_settings.bus_label_offset = { it[0].AsDouble(), it[1].AsDouble() };
     }
-    if (settings.count("stop_label_font_size"s)) {
-        render_settings.stop_label_font_size = settings.at("stop_label_font_size"s).AsDouble();
+    if (settings.count("stop_label_font_size"sv)) {
+        render_settings.stop_label_font_size = settings.at("stop_label_font_size"sv).AsDouble();
     }
-    if (settings.count("stop_label_offset"s)) {
-        auto it = settings.at("stop_label_offset"s).AsArray();
+    if (settings.count("stop_label_offset"sv)) {
+        auto it = settings.at("stop_label_offset"sv).AsArray();
         render_settings.stop_label_offset = { it[0].AsDouble(), it[1].AsDouble() };
     }
 
-    if (settings.count("underlayer_color"s)) {
-        GetColor(settings.at("underlayer_color"s), &render_settings.underlayer_color);
+    if (settings.count("underlayer_color"sv)) {
+        GetColor(settings.at("underlayer_color"sv), &render_settings.underlayer_color);
     }
-    if (settings.count("underlayer_width"s)) {
-        render_settings.underlayer_width = settings.at("underlayer_width"s).AsDouble();
+    if (settings.count("underlayer_width"sv)) {
+        render_settings.underlayer_width = settings.at("underlayer_width"sv).AsDouble();
     }
     //массив цветов
-    if (settings.count("color_palette"s)) {
-        auto& array = settings.at("color_palette"s).AsArray();
+    if (settings.count("color_palette"sv)) {
+        auto& array = settings.at("color_palette"sv).AsArray();
         render_settings.color_palette.reserve(array.size());
         for (auto& node : array) {
             render_settings.color_palette.push_back({});
@@ -198,13 +475,53 @@ void JsonReader::ParseRoutingSettings(const json::Node& node_)
 {
     auto& settings = node_.AsMap();
 
-    int bus_velocity = settings.at("bus_velocity"s).AsInt();
-    int bus_wait_time = settings.at("bus_wait_time"s).AsInt();
+    int bus_velocity = settings.at("bus_velocity"sv).AsInt();
+    int bus_wait_time = settings.at("bus_wait_time"sv).AsInt();
     //Значение — целое число от 1 до 1000
     if (bus_velocity < 0 || bus_wait_time < 0 || bus_velocity > 1000 || bus_wait_time > 1000) {
         throw std::invalid_argument("invalid routing_settings: 0 <= velocity, wait_time <= 1000"s);
     }
-    transport_router_.SetSettings({ static_cast<uint32_t>(bus_wait_time), static_cast<uint32_t>(bus_velocity) });
+    transport_router_::RouterType router_type = transport_router_::RouterType::ALL_PAIRS;
+    if (settings.count("router_type"sv)) {
+        const std::string& type = settings.at("router_type"sv).AsString();
+        if (type == "all_pairs"s) {
+            router_type = transport_router_::RouterType::ALL_PAIRS;
+        } else if (type == "dijkstra"s) {
+            router_type = transport_router_::RouterType::DIJKSTRA;
+        } else if (type == "contraction_hierarchies"s) {
+            router_type = transport_router_::RouterType::CONTRACTION_HIERARCHIES;
+        } else if (type == "a_star"s) {
+            router_type = transport_router_::RouterType::A_STAR;
+        } else if (type == "lazy_all_pairs"s) {
+            router_type = transport_router_::RouterType::LAZY_ALL_PAIRS;
+        } else if (type == "bidirectional_dijkstra"s) {
+            router_type = transport_router_::RouterType::BIDIRECTIONAL_DIJKSTRA;
+        } else if (type == "hub_labels"s) {
+            router_type = transport_router_::RouterType::HUB_LABELS;
+        } else {
+            throw std::invalid_argument("invalid routing_settings: unknown router_type "s + type);
+        }
+    }
+    bool report_expanded_vertices = settings.count("report_expanded_vertices"sv)
+            && settings.at("report_expanded_vertices"sv).AsBool();
+    transport_router_::GraphModel graph_model = transport_router_::GraphModel::COMPLETE;
+    if (settings.count("graph_model"sv)) {
+        const std::string& model = settings.at("graph_model"sv).AsString();
+        if (model == "complete"s) {
+            graph_model = transport_router_::GraphModel::COMPLETE;
+        } else if (model == "lines"s) {
+            graph_model = transport_router_::GraphModel::LINES;
+        } else {
+            throw std::invalid_argument("invalid routing_settings: unknown graph_model "s + model);
+        }
+    }
+    int route_cache_mb = settings.count("route_cache_mb"sv) ? settings.at("route_cache_mb"sv).AsInt() : 0;
+    if (route_cache_mb < 0) {
+        throw std::invalid_argument("invalid routing_settings: route_cache_mb < 0"s);
+    }
+    transport_router_.SetSettings({ static_cast<uint32_t>(bus_wait_time), static_cast<uint32_t>(bus_velocity),
+                                    router_type, report_expanded_vertices, graph_model,
+                                    static_cast<uint32_t>(route_cache_mb) });
 }
 
 void JsonReader::GetColor(const json::Node& node, svg::Color* color) {
@@ -276,8 +593,11 @@ json::Node JsonReader::CreateNode::operator() (domain::RouteOutput& value) {
     }
 
     builder.StartDict().Key("request_id"s).Value(value.id)
-            .Key("total_time"s).Value(result->total_time)
-            .Key("items"s).StartArray();
+            .Key("total_time"s).Value(result->total_time);
+    if (result->expanded_vertices) {
+        builder.Key("expanded_vertices"s).Value(static_cast<int>(*result->expanded_vertices));
+    }
+    builder.Key("items"s).StartArray();
 
     for (const transport_router_::CompletedRoute::Line& line : result->route) {
         builder.StartDict().Key("stop_name"s).Value(line.stop->name)
@@ -291,3 +611,37 @@ json::Node JsonReader::CreateNode::operator() (domain::RouteOutput& value) {
     builder.EndArray().EndDict();
     return builder.Build();
 }
+
+json::Node JsonReader::CreateNode::operator() (domain::RouteMatrixOutput& value) {
+
+    std::vector<graph::VertexId> targets;
+    targets.reserve(value.targets.size());
+    for (const domain::Stop* stop : value.targets) {
+        targets.push_back(stop->vertex_id);
+    }
+
+    json::Builder builder;
+    builder.StartDict().Key("request_id"s).Value(value.id)
+            .Key("total_times"s).StartArray();
+    for (const domain::Stop* source : value.sources) {
+        builder.StartArray();
+        //недостижимая остановка — null
+        for (const std::optional<double>& time : transport_router_.ComputeTimes(source->vertex_id, targets)) {
+            builder.Value(time ? json::Node(*time) : json::Node(nullptr));
+        }
+        builder.EndArray();
+    }
+    return builder.EndArray().EndDict().Build();
+}
+
+json::Node JsonReader::CreateNode::operator() (domain::IsochroneOutput& value) {
+
+    json::Builder builder;
+    builder.StartDict().Key("request_id"s).Value(value.id)
+            .Key("stops"s).StartArray();
+    for (const auto& [stop, time] : transport_router_.ComputeIsochrone(value.from->vertex_id, value.time_limit)) {
+        builder.StartDict().Key("stop_name"s).Value(stop->name)
+                .Key("time"s).Value(time).EndDict();
+    }
+    return builder.EndArray().EndDict().Build();
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include <cstddef>
 #include <iterator>
 #include <string_view>
 #include <unordered_map>
@@ -32,4 +33,46 @@ auto AsRange(const C& container) {
     return Range{container.begin(), container.end()};
 }
 
+//итератор по последовательным целым значениям
+template <typename T>
+class CountingIterator {
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const T*;
+    using reference = T;
+
+    explicit CountingIterator(T value)
+        : value_(value) {
+    }
+    T operator*() const {
+        return value_;
+    }
+    CountingIterator& operator++() {
+        ++value_;
+        return *this;
+    }
+    CountingIterator operator++(int) {
+        CountingIterator result = *this;
+        ++value_;
+        return result;
+    }
+    bool operator==(const CountingIterator& other) const {
+        return value_ == other.value_;
+    }
+    bool operator!=(const CountingIterator& other) const {
+        return value_ != other.value_;
+    }
+
+private:
+    T value_;
+};
+
+//диапазон [begin, end) целых значений
+template <typename T>
+auto AsCountingRange(T begin, T end) {
+    return Range{CountingIterator<T>(begin), CountingIterator<T>(end)};
+}
+
 }  
\ No newline at end of file
@@ -17,11 +17,15 @@ public:
         : input_(input), db_(db), reader_(db_, router_,map_renderer_,serializator_), map_renderer_(db_),
           router_(db_),serializator_(db_, map_renderer_,router_){}
 
-    void ReadInputDocument();
+    //add_stops — остановки base_requests добавляются в справочник при чтении (make_base)
+    void ReadInputDocument(bool add_stops = false);
     //печать ответа
     void PrintAnswers();
 
 	void AddInfo();
+	//дополнение восстановленной базы: новые остановки и автобусы, изменённые расстояния;
+	//граф и маршрутизатор обновляются без полной перестройки, если это возможно
+	void UpdateInfo();
 
     // Возвращает информацию о маршруте (запрос Bus)
     std::optional<const domain::Bus *> GetBusStat(const std::string_view &bus_name) const;
@@ -36,6 +40,9 @@ public:
 
     size_t Serialize(bool with_graph = false) const  {return serializator_.Serialize(with_graph);}
     bool Deserialize(bool with_graph = false)  {return serializator_.Deserialize(with_graph); }
+    //загружает справочник и только те части снапшота, что нужны запросам stat_requests:
+    //маршрутизатор — для Route, RouteMatrix и Isochrone, настройки отрисовки — для Map
+    bool DeserializeForRequests(bool with_graph = false);
 
     void GetAnswers();
 
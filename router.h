@@ -2,11 +2,15 @@
 #include "graph.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstdint>
 #include <iterator>
+#include <limits>
 #include <optional>
+#include <queue>
 #include <stdexcept>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -18,159 +22,550 @@ template <typename Weight>
 class Router {
 private:
     using Graph = DirectedWeightedGraph<Weight>;
-    struct RouteInternalData {
-        Weight weight;
-        std::optional<EdgeId> prev_edge;
+    //Матрица V×V одним непрерывным блоком, веса и рёбра-предшественники — отдельными массивами
+    //(12 байт на ячейку для double вместо 32 у optional<{double, optional<size_t>}>).
+    struct RoutesInternalData {
+        std::vector<Weight> weights;
+        std::vector<uint32_t> prev_edges;
+    };
+    //указатели на начало строки (или её копии) в обоих массивах
+    struct ConstRowRef {
+        const Weight* weights;
+        const uint32_t* prev_edges;
+    };
+    struct RowRef {
+        Weight* weights;
+        uint32_t* prev_edges;
+
+        operator ConstRowRef() const {
+            return {weights, prev_edges};
+        }
     };
-    using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
 
 public:
-    explicit Router(const Graph& graph);
+    //thread_count == 0 — по числу аппаратных потоков
+    explicit Router(const Graph& graph, size_t thread_count = 0);
     Router(const Graph& graph, const transport_catalog_serialize::RoutesData& routes_data);
 
-    struct RouteInfo {
-        Weight weight;
-        std::vector<EdgeId> edges;
+    //таблица V×V построчно: веса и последние рёбра маршрутов (NO_EDGE/UNREACHABLE — как в RoutesData)
+    struct TableView {
+        ranges::Range<const Weight*> weights{nullptr, nullptr};
+        ranges::Range<const uint32_t*> prev_edges{nullptr, nullptr};
+        size_t vertex_count = 0;
     };
+    //таблица в чужой памяти (плоский снапшот): читается на месте, память должна жить дольше маршрутизатора
+    Router(const Graph& graph, TableView table);
+
+    //Ленивая таблица: строка из вершины считается Дейкстрой при первом запросе из неё и кэшируется.
+    //memory_budget — байт на кэш строк (0 — без ограничения); сверх него вытесняется строка,
+    //дольше всех не использовавшаяся
+    struct LazyRows {
+        size_t memory_budget = 0;
+    };
+    Router(const Graph& graph, LazyRows lazy_rows);
+
+    using RouteInfo = graph::RouteInfo<Weight>;
 
-    transport_catalog_serialize::RoutesData GetSerializeData() const;
+    //таблица для записи снапшота без копирования
+    TableView GetTable() const;
 
     std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+    //вес маршрута без восстановления рёбер
+    std::optional<Weight> GetWeight(VertexId from, VertexId to) const;
+
+    //чинит таблицу после изменения весов рёбер в графе; previous_weights — изменённые рёбра с прежними весами.
+    //Строки, в дереве кратчайших путей которых есть подорожавшее ребро, пересчитываются Дейкстрой,
+    //подешевевшие рёбра релаксируют остальные строки за O(V²) на ребро. Ленивая таблица просто сбрасывает кэш
+    void UpdateEdges(const std::vector<std::pair<EdgeId, Weight>>& previous_weights, size_t thread_count = 0);
 
 private:
+    //значения prev_edges: маршрут из вершины в себя (без рёбер) и отсутствие маршрута
+    static constexpr uint32_t NO_EDGE = std::numeric_limits<uint32_t>::max() - 1;
+    static constexpr uint32_t UNREACHABLE = std::numeric_limits<uint32_t>::max();
+    //строка вершины не загружена в кэш
+    static constexpr uint32_t NO_SLOT = std::numeric_limits<uint32_t>::max();
+
+    size_t CellIndex(VertexId from, VertexId to) const {
+        return from * vertex_count_ + to;
+    }
 
+    RowRef Row(VertexId from) {
+        return {&routes_internal_data_.weights[CellIndex(from, 0)], &routes_internal_data_.prev_edges[CellIndex(from, 0)]};
+    }
+
+    //начало таблицы: собственной или в чужой памяти
+    ConstRowRef Table() const {
+        if (external_table_.weights) {
+            return external_table_;
+        }
+        return {routes_internal_data_.weights.data(), routes_internal_data_.prev_edges.data()};
+    }
+
+    //строка from для чтения; в ленивом режиме — из кэша, при промахе считается
+    ConstRowRef TableRow(VertexId from) const {
+        if (lazy_) {
+            const size_t offset = LoadRow(from);
+            return {&cached_rows_.weights[offset], &cached_rows_.prev_edges[offset]};
+        }
+        const ConstRowRef table = Table();
+        return {table.weights + CellIndex(from, 0), table.prev_edges + CellIndex(from, 0)};
+    }
 
     void InitializeRoutesInternalData(const Graph& graph) {
-        const size_t vertex_count = graph.GetVertexCount();
-        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
-            routes_internal_data_[vertex][vertex] = RouteInternalData{ZERO_WEIGHT, std::nullopt};
+        if (graph.GetEdgeCount() >= NO_EDGE) {
+            throw std::length_error("Too many edges for the route table");
+        }
+        routes_internal_data_.weights.assign(vertex_count_ * vertex_count_, ZERO_WEIGHT);
+        routes_internal_data_.prev_edges.assign(vertex_count_ * vertex_count_, UNREACHABLE);
+        for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+            routes_internal_data_.prev_edges[CellIndex(vertex, vertex)] = NO_EDGE;
             for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
-                const auto& edge = graph.GetEdge(edge_id);
+                const auto edge = graph.GetEdge(edge_id);
                 if (edge.weight < ZERO_WEIGHT) {
                     throw std::domain_error("Edges' weights should be non-negative");
                 }
-                auto& route_internal_data = routes_internal_data_[vertex][edge.to];
-                if (!route_internal_data || route_internal_data->weight > edge.weight) {
-                    route_internal_data = RouteInternalData{edge.weight, edge_id};
+                const size_t cell = CellIndex(vertex, edge.to);
+                if (routes_internal_data_.prev_edges[cell] == UNREACHABLE
+                        || routes_internal_data_.weights[cell] > edge.weight) {
+                    routes_internal_data_.weights[cell] = edge.weight;
+                    routes_internal_data_.prev_edges[cell] = static_cast<uint32_t>(edge_id);
                 }
             }
         }
     }
 
-    void RelaxRoute(VertexId vertex_from, VertexId vertex_to, const RouteInternalData& route_from,
-                    const RouteInternalData& route_to) {
-        auto& route_relaxing = routes_internal_data_[vertex_from][vertex_to];
-        const Weight candidate_weight = route_from.weight + route_to.weight;
-        if (!route_relaxing || candidate_weight < route_relaxing->weight) {
-            route_relaxing = {candidate_weight,
-                              route_to.prev_edge ? route_to.prev_edge : route_from.prev_edge};
+    //релаксирует столбцы [column_begin, column_end) строки row через промежуточную вершину:
+    //маршрут до неё (from_weight, from_prev_edge) и её строка на текущем шаге pivot_row
+    static void RelaxRowRange(RowRef row, Weight from_weight, uint32_t from_prev_edge, ConstRowRef pivot_row,
+                              VertexId column_begin, VertexId column_end) {
+        for (VertexId vertex_to = column_begin; vertex_to < column_end; ++vertex_to) {
+            const uint32_t to_prev_edge = pivot_row.prev_edges[vertex_to];
+            if (to_prev_edge == UNREACHABLE) {
+                continue;
+            }
+            const Weight candidate_weight = from_weight + pivot_row.weights[vertex_to];
+            if (row.prev_edges[vertex_to] == UNREACHABLE || candidate_weight < row.weights[vertex_to]) {
+                row.weights[vertex_to] = candidate_weight;
+                row.prev_edges[vertex_to] = to_prev_edge != NO_EDGE ? to_prev_edge : from_prev_edge;
+            }
         }
     }
 
-    void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through) {
-        for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
-            if (const auto& route_from = routes_internal_data_[vertex_from][vertex_through]) {
-                for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
-                    if (const auto& route_to = routes_internal_data_[vertex_through][vertex_to]) {
-                        RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
-                    }
+    //то же, пропуская столбцы блока [block_begin, block_end)
+    static void RelaxRowRangeOutsideBlock(RowRef row, Weight from_weight, uint32_t from_prev_edge,
+                                          ConstRowRef pivot_row, VertexId column_begin, VertexId column_end,
+                                          VertexId block_begin, VertexId block_end) {
+        RelaxRowRange(row, from_weight, from_prev_edge, pivot_row, column_begin, std::min(column_end, block_begin));
+        RelaxRowRange(row, from_weight, from_prev_edge, pivot_row, std::max(column_begin, block_end), column_end);
+    }
+
+    //Флойд–Уоршелл блоками по BLOCK_SIZE промежуточных вершин. Внутри блока шаги k идут
+    //в том же порядке, что и в последовательном алгоритме, поэтому каждая ячейка получает
+    //ту же последовательность релаксаций и результат побитово совпадает с ним.
+    //Для каждого шага k сохраняется строка k в состоянии "на шаге k" (pivot_rows_), после чего
+    //строки и столбцы вне блока независимы и обрабатываются параллельно тайлами.
+    void RelaxRoutesInternalData(size_t thread_count) {
+        for (VertexId block_begin = 0; block_begin < vertex_count_; block_begin += BLOCK_SIZE) {
+            const VertexId block_end = std::min(vertex_count_, block_begin + BLOCK_SIZE);
+            RelaxDiagonalBlock(block_begin, block_end);
+            //строки блока: параллельно по тайлам столбцов вне блока
+            const size_t column_tiles = (vertex_count_ + TILE_SIZE - 1) / TILE_SIZE;
+            ParallelFor(column_tiles, thread_count, [&](size_t tile) {
+                RelaxPivotRowsTile(block_begin, block_end, tile * TILE_SIZE,
+                                   std::min(vertex_count_, (tile + 1) * TILE_SIZE));
+            });
+            //остальные строки: параллельно полосами строк
+            const size_t row_strips = (vertex_count_ + STRIP_SIZE - 1) / STRIP_SIZE;
+            ParallelFor(row_strips, thread_count, [&](size_t strip) {
+                RelaxRowsStrip(block_begin, block_end, strip * STRIP_SIZE,
+                               std::min(vertex_count_, (strip + 1) * STRIP_SIZE));
+            });
+        }
+    }
+
+    RowRef PivotRow(size_t through_index) {
+        return {&pivot_rows_.weights[through_index * vertex_count_], &pivot_rows_.prev_edges[through_index * vertex_count_]};
+    }
+
+    //диагональный блок: строки и столбцы из [block_begin, block_end)
+    void RelaxDiagonalBlock(VertexId block_begin, VertexId block_end) {
+        const size_t block_size = block_end - block_begin;
+        pivot_rows_.weights.assign(block_size * vertex_count_, ZERO_WEIGHT);
+        pivot_rows_.prev_edges.assign(block_size * vertex_count_, UNREACHABLE);
+        pivot_from_.weights.assign(block_size * block_size, ZERO_WEIGHT);
+        pivot_from_.prev_edges.assign(block_size * block_size, UNREACHABLE);
+        for (VertexId vertex_through = block_begin; vertex_through < block_end; ++vertex_through) {
+            const size_t through_index = vertex_through - block_begin;
+            const RowRef pivot_row = PivotRow(through_index);
+            for (VertexId vertex = block_begin; vertex < block_end; ++vertex) {
+                pivot_row.weights[vertex] = routes_internal_data_.weights[CellIndex(vertex_through, vertex)];
+                pivot_row.prev_edges[vertex] = routes_internal_data_.prev_edges[CellIndex(vertex_through, vertex)];
+                const size_t from_cell = (vertex - block_begin) * block_size + through_index;
+                pivot_from_.weights[from_cell] = routes_internal_data_.weights[CellIndex(vertex, vertex_through)];
+                pivot_from_.prev_edges[from_cell] = routes_internal_data_.prev_edges[CellIndex(vertex, vertex_through)];
+            }
+            for (VertexId vertex_from = block_begin; vertex_from < block_end; ++vertex_from) {
+                const size_t from_cell = (vertex_from - block_begin) * block_size + through_index;
+                if (pivot_from_.prev_edges[from_cell] != UNREACHABLE) {
+                    RelaxRowRange(Row(vertex_from), pivot_from_.weights[from_cell], pivot_from_.prev_edges[from_cell],
+                                  pivot_row, block_begin, block_end);
+                }
+            }
+        }
+    }
+
+    //строки блока, столбцы [column_begin, column_end) вне блока
+    void RelaxPivotRowsTile(VertexId block_begin, VertexId block_end, VertexId column_begin, VertexId column_end) {
+        const size_t block_size = block_end - block_begin;
+        for (VertexId vertex_through = block_begin; vertex_through < block_end; ++vertex_through) {
+            const size_t through_index = vertex_through - block_begin;
+            const RowRef pivot_row = PivotRow(through_index);
+            const RowRef row_through = Row(vertex_through);
+            //столбцы блока уже сохранены на своих шагах в RelaxDiagonalBlock
+            for (VertexId vertex_to = column_begin; vertex_to < column_end; ++vertex_to) {
+                if (vertex_to < block_begin || vertex_to >= block_end) {
+                    pivot_row.weights[vertex_to] = row_through.weights[vertex_to];
+                    pivot_row.prev_edges[vertex_to] = row_through.prev_edges[vertex_to];
+                }
+            }
+            for (VertexId vertex_from = block_begin; vertex_from < block_end; ++vertex_from) {
+                const size_t from_cell = (vertex_from - block_begin) * block_size + through_index;
+                if (pivot_from_.prev_edges[from_cell] != UNREACHABLE) {
+                    RelaxRowRangeOutsideBlock(Row(vertex_from), pivot_from_.weights[from_cell],
+                                              pivot_from_.prev_edges[from_cell], pivot_row,
+                                              column_begin, column_end, block_begin, block_end);
                 }
             }
         }
     }
 
-    RoutesInternalData SetDeserializeData(const transport_catalog_serialize::RoutesData& data) const{
-        RoutesInternalData routes_internal_data;
-        routes_internal_data.reserve(data.data_size());
-        for (int i = 0; i < data.data_size(); ++i) {
-            const transport_catalog_serialize::ArrayRouteInternalData& array_in = data.data(i);
-            std::vector<std::optional<RouteInternalData>> array_to_write;
-            array_to_write.reserve(array_in.data_size());
-            for (int j = 0; j < array_in.data_size(); ++j) {
-                if (array_in.data(j).has_value()){
-                    const transport_catalog_serialize::RouteInternalData& route_in = array_in.data(j);
-                    std::optional<EdgeId> prev_edge;
-                    if (route_in.prev_edge() == -1) {
-                        prev_edge = std::nullopt;
-                    } else {
-                        prev_edge = static_cast<EdgeId>(route_in.prev_edge());
+    //строки [row_begin, row_end) вне блока; сначала столбцы блока (значения d[i][k] на шаге k),
+    //затем остальные столбцы тайлами, чтобы тайл pivot_rows_ оставался в кэше для всей полосы
+    void RelaxRowsStrip(VertexId block_begin, VertexId block_end, VertexId row_begin, VertexId row_end) {
+        const size_t block_size = block_end - block_begin;
+        RoutesInternalData routes_from{std::vector<Weight>((row_end - row_begin) * block_size),
+                                       std::vector<uint32_t>((row_end - row_begin) * block_size)};
+        for (VertexId vertex_from = row_begin; vertex_from < row_end; ++vertex_from) {
+            if (vertex_from >= block_begin && vertex_from < block_end) {
+                continue;
+            }
+            const RowRef row = Row(vertex_from);
+            const size_t from_offset = (vertex_from - row_begin) * block_size;
+            for (VertexId vertex_through = block_begin; vertex_through < block_end; ++vertex_through) {
+                const size_t through_index = vertex_through - block_begin;
+                const Weight from_weight = routes_from.weights[from_offset + through_index] = row.weights[vertex_through];
+                const uint32_t from_prev_edge = routes_from.prev_edges[from_offset + through_index]
+                        = row.prev_edges[vertex_through];
+                if (from_prev_edge != UNREACHABLE) {
+                    RelaxRowRange(row, from_weight, from_prev_edge, PivotRow(through_index), block_begin, block_end);
+                }
+            }
+        }
+        for (VertexId column_begin = 0; column_begin < vertex_count_; column_begin += TILE_SIZE) {
+            const VertexId column_end = std::min(vertex_count_, column_begin + TILE_SIZE);
+            for (VertexId vertex_from = row_begin; vertex_from < row_end; ++vertex_from) {
+                if (vertex_from >= block_begin && vertex_from < block_end) {
+                    continue;
+                }
+                const RowRef row = Row(vertex_from);
+                const size_t from_offset = (vertex_from - row_begin) * block_size;
+                for (size_t through_index = 0; through_index < block_size; ++through_index) {
+                    const uint32_t from_prev_edge = routes_from.prev_edges[from_offset + through_index];
+                    if (from_prev_edge != UNREACHABLE) {
+                        RelaxRowRangeOutsideBlock(row, routes_from.weights[from_offset + through_index], from_prev_edge,
+                                                  PivotRow(through_index), column_begin, column_end,
+                                                  block_begin, block_end);
                     }
-                    array_to_write.push_back(RouteInternalData{route_in.weight(), prev_edge});
-                } else {
-                    array_to_write.push_back(std::nullopt);
                 }
             }
-            routes_internal_data.push_back(move(array_to_write));
         }
-        return routes_internal_data;
+    }
+
+    //выполняет func(task) для task из [0, task_count) на thread_count потоках
+    template <typename Func>
+    static void ParallelFor(size_t task_count, size_t thread_count, Func func) {
+        std::atomic<size_t> next_task{0};
+        auto worker = [&next_task, task_count, &func] {
+            for (size_t task = next_task++; task < task_count; task = next_task++) {
+                func(task);
+            }
+        };
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < std::min(thread_count, task_count); ++i) {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+
+    //место под ещё один слот кэша. При бюджете память под все слоты выделяется сразу, иначе вектор растёт
+    //удвоением, но не дальше max_cached_rows_ строк: удвоение сверх предела превышало бы бюджет до двух раз
+    void ReserveCachedRow() const {
+        const size_t needed = cached_rows_.weights.size() + vertex_count_;
+        if (needed <= cached_rows_.weights.capacity()) {
+            return;
+        }
+        const size_t limit = max_cached_rows_ * vertex_count_;
+        const size_t capacity = max_cached_rows_ < vertex_count_
+                ? limit : std::min(std::max(needed, cached_rows_.weights.capacity() * 2), limit);
+        cached_rows_.weights.reserve(capacity);
+        cached_rows_.prev_edges.reserve(capacity);
+    }
+
+    //смещение строки from в кэше; при промахе строка считается в свободный или вытесненный слот
+    size_t LoadRow(VertexId from) const {
+        ++use_clock_;
+        uint32_t slot = row_slots_[from];
+        if (slot == NO_SLOT) {
+            if (slot_vertices_.size() < max_cached_rows_) {
+                slot = static_cast<uint32_t>(slot_vertices_.size());
+                slot_vertices_.push_back(from);
+                slot_last_use_.push_back(0);
+                ReserveCachedRow();
+                cached_rows_.weights.resize(cached_rows_.weights.size() + vertex_count_);
+                cached_rows_.prev_edges.resize(cached_rows_.prev_edges.size() + vertex_count_);
+            } else {
+                //промах и так стоит поиска по графу, линейный выбор жертвы на его фоне незаметен
+                slot = static_cast<uint32_t>(std::min_element(slot_last_use_.begin(), slot_last_use_.end())
+                                             - slot_last_use_.begin());
+                row_slots_[slot_vertices_[slot]] = NO_SLOT;
+                slot_vertices_[slot] = from;
+            }
+            row_slots_[from] = slot;
+            ComputeRow(from, {&cached_rows_.weights[slot * vertex_count_],
+                              &cached_rows_.prev_edges[slot * vertex_count_]});
+        }
+        slot_last_use_[slot] = use_clock_;
+        return slot * vertex_count_;
+    }
+
+    //строка from: Дейкстра с бинарной кучей, prev_edges — последнее ребро кратчайшего пути
+    void ComputeRow(VertexId from, RowRef row) const {
+        std::fill(row.weights, row.weights + vertex_count_, ZERO_WEIGHT);
+        std::fill(row.prev_edges, row.prev_edges + vertex_count_, UNREACHABLE);
+        using QueueItem = std::pair<Weight, VertexId>;
+        std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+        row.prev_edges[from] = NO_EDGE;
+        queue.push({ZERO_WEIGHT, from});
+        while (!queue.empty()) {
+            const auto [weight, vertex] = queue.top();
+            queue.pop();
+            if (weight > row.weights[vertex]) {
+                continue;   //устаревшая запись в очереди
+            }
+            for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+                const auto edge = graph_.GetEdge(edge_id);
+                const Weight candidate_weight = weight + edge.weight;
+                if (row.prev_edges[edge.to] == UNREACHABLE || candidate_weight < row.weights[edge.to]) {
+                    row.weights[edge.to] = candidate_weight;
+                    row.prev_edges[edge.to] = static_cast<uint32_t>(edge_id);
+                    queue.push({candidate_weight, edge.to});
+                }
+            }
+        }
+    }
+
+    void SetDeserializeData(const transport_catalog_serialize::RoutesData& data) {
+        vertex_count_ = data.vertex_count();
+        routes_internal_data_.weights = LoadWeights<Weight>(data.weights(), data.float_weights());
+        routes_internal_data_.prev_edges.assign(data.prev_edges().begin(), data.prev_edges().end());
+        if (routes_internal_data_.weights.size() != vertex_count_ * vertex_count_
+                || routes_internal_data_.prev_edges.size() != vertex_count_ * vertex_count_) {
+            throw std::invalid_argument("Inconsistent route table data");
+        }
     }
 
     static constexpr Weight ZERO_WEIGHT{};
+    static constexpr size_t BLOCK_SIZE = 64;
+    static constexpr size_t TILE_SIZE = 256;
+    static constexpr size_t STRIP_SIZE = 32;
     const Graph& graph_;
+    size_t vertex_count_ = 0;
     RoutesInternalData routes_internal_data_;
+    //таблица в чужой памяти; копируется в routes_internal_data_ перед изменением
+    ConstRowRef external_table_{nullptr, nullptr};
+    //рабочие буферы построения: строки блока на своём шаге и значения d[k'][k] внутри блока
+    RoutesInternalData pivot_rows_;
+    RoutesInternalData pivot_from_;
+    //ленивый режим: строки в слотах cached_rows_, слот вершины и время последнего обращения к слоту
+    bool lazy_ = false;
+    size_t max_cached_rows_ = 0;
+    mutable RoutesInternalData cached_rows_;
+    mutable std::vector<uint32_t> row_slots_;
+    mutable std::vector<VertexId> slot_vertices_;
+    mutable std::vector<uint64_t> slot_last_use_;
+    mutable uint64_t use_clock_ = 0;
 };
 template <typename Weight>
-transport_catalog_serialize::RoutesData Router<Weight>::GetSerializeData() const {
-    transport_catalog_serialize::RoutesData data_out;
-    for (const std::vector<std::optional<RouteInternalData>>& array_route_internal_data : routes_internal_data_) {
-        transport_catalog_serialize::ArrayRouteInternalData array_out;
-        for (const std::optional<RouteInternalData>& route : array_route_internal_data) {
-            transport_catalog_serialize::RouteInternalData route_out;
-            if (route) {
-                route_out.set_weight(route->weight);
-                if (route->prev_edge) {
-                    route_out.set_prev_edge(*route->prev_edge);
-                } else {
-                    route_out.set_prev_edge(-1);
-                }
-                route_out.set_has_value(true);
-            } else {
-                route_out.set_has_value(false);
-            }
-            array_out.add_data();
-            *array_out.mutable_data(array_out.data_size()-1) = std::move(route_out);
-        }
-        data_out.add_data();
-        *data_out.mutable_data(data_out.data_size()-1) = std::move(array_out);
+typename Router<Weight>::TableView Router<Weight>::GetTable() const {
+    if (lazy_) {
+        throw std::logic_error("Lazy route table is not serializable");
     }
-    return data_out;
+    const ConstRowRef table = Table();
+    const size_t cell_count = vertex_count_ * vertex_count_;
+    return {{table.weights, table.weights + cell_count}, {table.prev_edges, table.prev_edges + cell_count}, vertex_count_};
 }
 
 template <typename Weight>
-Router<Weight>::Router(const Graph& graph)
+Router<Weight>::Router(const Graph& graph, size_t thread_count)
     : graph_(graph)
-    , routes_internal_data_(graph.GetVertexCount(),
-                            std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()))
+    , vertex_count_(graph.GetVertexCount())
 {
     InitializeRoutesInternalData(graph);
 
-    const size_t vertex_count = graph.GetVertexCount();
-    for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
-        RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
+    if (thread_count == 0) {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
     }
+    RelaxRoutesInternalData(thread_count);
+    pivot_rows_ = {};
+    pivot_from_ = {};
 }
 template <typename Weight>
 Router<Weight>::Router(const Graph& graph, const transport_catalog_serialize::RoutesData& routes_data)
     :graph_(graph)
-    ,routes_internal_data_(SetDeserializeData(routes_data)){}
+{
+    SetDeserializeData(routes_data);
+}
+template <typename Weight>
+Router<Weight>::Router(const Graph& graph, TableView table)
+    : graph_(graph)
+    , vertex_count_(graph.GetVertexCount())
+    , external_table_{table.weights.begin(), table.prev_edges.begin()}
+{
+    const size_t cell_count = vertex_count_ * vertex_count_;
+    if (static_cast<size_t>(table.weights.end() - table.weights.begin()) != cell_count
+            || static_cast<size_t>(table.prev_edges.end() - table.prev_edges.begin()) != cell_count) {
+        throw std::invalid_argument("Inconsistent route table data");
+    }
+}
+template <typename Weight>
+Router<Weight>::Router(const Graph& graph, LazyRows lazy_rows)
+    : graph_(graph)
+    , vertex_count_(graph.GetVertexCount())
+    , lazy_(true)
+    , row_slots_(graph.GetVertexCount(), NO_SLOT)
+{
+    if (graph.GetEdgeCount() >= NO_EDGE) {
+        throw std::length_error("Too many edges for the route table");
+    }
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+    const size_t row_size = vertex_count_ * (sizeof(Weight) + sizeof(uint32_t));
+    max_cached_rows_ = vertex_count_;
+    if (lazy_rows.memory_budget > 0 && row_size > 0) {
+        max_cached_rows_ = std::clamp<size_t>(lazy_rows.memory_budget / row_size, 1, vertex_count_);
+    }
+}
 
 template <typename Weight>
 std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
                                                                              VertexId to) const {
-    const auto& route_internal_data = routes_internal_data_.at(from).at(to);
-    if (!route_internal_data) {
+    if (from >= vertex_count_ || to >= vertex_count_) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    const ConstRowRef row = TableRow(from);
+    if (row.prev_edges[to] == UNREACHABLE) {
         return std::nullopt;
     }
-    const Weight weight = route_internal_data->weight;
+    const Weight weight = row.weights[to];
     std::vector<EdgeId> edges;
-    for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
-         edge_id;
-         edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge)
+    for (uint32_t edge_id = row.prev_edges[to];
+         edge_id != NO_EDGE;
+         edge_id = row.prev_edges[graph_.GetEdge(edge_id).from])
     {
-        edges.push_back(*edge_id);
+        edges.push_back(edge_id);
     }
     std::reverse(edges.begin(), edges.end());
 
     return RouteInfo{weight, std::move(edges)};
 }
-}  
+
+template <typename Weight>
+std::optional<Weight> Router<Weight>::GetWeight(VertexId from, VertexId to) const {
+    if (from >= vertex_count_ || to >= vertex_count_) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    const ConstRowRef row = TableRow(from);
+    if (row.prev_edges[to] == UNREACHABLE) {
+        return std::nullopt;
+    }
+    return row.weights[to];
+}
+
+template <typename Weight>
+void Router<Weight>::UpdateEdges(const std::vector<std::pair<EdgeId, Weight>>& previous_weights,
+                                 size_t thread_count) {
+    if (lazy_) {
+        std::fill(row_slots_.begin(), row_slots_.end(), NO_SLOT);
+        slot_vertices_.clear();
+        slot_last_use_.clear();
+        cached_rows_ = {};
+        return;
+    }
+    if (external_table_.weights) {
+        const size_t cell_count = vertex_count_ * vertex_count_;
+        routes_internal_data_.weights.assign(external_table_.weights, external_table_.weights + cell_count);
+        routes_internal_data_.prev_edges.assign(external_table_.prev_edges, external_table_.prev_edges + cell_count);
+        external_table_ = {nullptr, nullptr};
+    }
+    if (thread_count == 0) {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    const size_t row_strips = (vertex_count_ + STRIP_SIZE - 1) / STRIP_SIZE;
+    //ребро e = (u, v) входит в дерево кратчайших путей строки s, только если prev_edges[s][v] == e
+    std::vector<char> recompute(vertex_count_, false);
+    for (const auto& [edge_id, previous_weight] : previous_weights) {
+        const auto edge = graph_.GetEdge(edge_id);
+        if (edge.weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+        if (edge.weight > previous_weight) {
+            for (VertexId vertex_from = 0; vertex_from < vertex_count_; ++vertex_from) {
+                if (routes_internal_data_.prev_edges[CellIndex(vertex_from, edge.to)] == edge_id) {
+                    recompute[vertex_from] = true;
+                }
+            }
+        }
+    }
+    ParallelFor(row_strips, thread_count, [&](size_t strip) {
+        for (VertexId vertex_from = strip * STRIP_SIZE; vertex_from < std::min(vertex_count_, (strip + 1) * STRIP_SIZE);
+             ++vertex_from) {
+            if (recompute[vertex_from]) {
+                ComputeRow(vertex_from, Row(vertex_from));
+            }
+        }
+    });
+    //подешевевшее ребро: d[s][t] = min(d[s][t], d[s][u] + w + d[v][t]); строка v при этом не меняется,
+    //поэтому строки обрабатываются параллельно. Пересчитанные строки уже точны и не улучшатся
+    for (const auto& [edge_id, previous_weight] : previous_weights) {
+        const auto edge = graph_.GetEdge(edge_id);
+        if (!(edge.weight < previous_weight)) {
+            continue;
+        }
+        const ConstRowRef pivot_row = Row(edge.to);
+        ParallelFor(row_strips, thread_count, [&](size_t strip) {
+            for (VertexId vertex_from = strip * STRIP_SIZE;
+                 vertex_from < std::min(vertex_count_, (strip + 1) * STRIP_SIZE); ++vertex_from) {
+                const size_t from_cell = CellIndex(vertex_from, edge.from);
+                const size_t to_cell = CellIndex(vertex_from, edge.to);
+                if (routes_internal_data_.prev_edges[from_cell] == UNREACHABLE) {
+                    continue;
+                }
+                const Weight from_weight = routes_internal_data_.weights[from_cell] + edge.weight;
+                //если ребро не улучшает путь до v, то не улучшает и пути через v
+                if (routes_internal_data_.prev_edges[to_cell] != UNREACHABLE
+                        && !(from_weight < routes_internal_data_.weights[to_cell])) {
+                    continue;
+                }
+                RelaxRowRange(Row(vertex_from), from_weight, static_cast<uint32_t>(edge_id), pivot_row,
+                              0, vertex_count_);
+            }
+        });
+    }
+}
+}
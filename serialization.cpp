@@ -1,28 +1,382 @@
 #include "serialization.h"
+#include <algorithm>
 #include <fstream>
+#include <numeric>
+
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl.h>
+#include <google/protobuf/wire_format_lite.h>
 
 namespace serialize {
 
+using namespace std::literals;
+using google::protobuf::internal::WireFormatLite;
+using google::protobuf::io::CodedOutputStream;
+
+namespace {
+
+using RouteTable = graph::Router<transport_router_::RouteWeight>::TableView;
+
+//упакованное поле фиксированного размера: тег, длина, значения
+template <typename T>
+size_t PackedFieldSize(int field_number, ranges::Range<const T*> values) {
+    const size_t bytes = (values.end() - values.begin()) * sizeof(T);
+    if (bytes == 0) {
+        return 0;
+    }
+    return WireFormatLite::TagSize(field_number, WireFormatLite::TYPE_BYTES)
+            + CodedOutputStream::VarintSize64(bytes) + bytes;
+}
+
+template <typename T>
+void WritePackedField(int field_number, ranges::Range<const T*> values, CodedOutputStream& output) {
+    const size_t count = values.end() - values.begin();
+    if (count == 0) {
+        return;
+    }
+    WireFormatLite::WriteTag(field_number, WireFormatLite::WIRETYPE_LENGTH_DELIMITED, &output);
+    output.WriteVarint64(count * sizeof(T));
+    //массивы пишутся блоками: счётчик элементов в WriteXxxArray — int
+    constexpr size_t CHUNK = size_t(1) << 20;
+    for (size_t begin = 0; begin < count; begin += CHUNK) {
+        const int chunk = static_cast<int>(std::min(CHUNK, count - begin));
+        if constexpr (std::is_same_v<T, double>) {
+            WireFormatLite::WriteDoubleArray(values.begin() + begin, chunk, &output);
+        } else if constexpr (std::is_same_v<T, float>) {
+            WireFormatLite::WriteFloatArray(values.begin() + begin, chunk, &output);
+        } else {
+            WireFormatLite::WriteFixed32Array(values.begin() + begin, chunk, &output);
+        }
+    }
+}
+
+//вложенное сообщение: размер считается здесь, WireFormatLite::WriteMessage берёт уже посчитанный
+void WriteMessageField(int field_number, const google::protobuf::MessageLite& message, CodedOutputStream& output) {
+    const size_t size = message.ByteSizeLong();
+    WireFormatLite::WriteTag(field_number, WireFormatLite::WIRETYPE_LENGTH_DELIMITED, &output);
+    output.WriteVarint64(size);
+    message.SerializeWithCachedSizes(&output);
+}
+
+//таблица маршрутов — отдельное вхождение поля router_data, содержащее только RoutesData:
+//при разборе вхождения сообщения сливаются, а таблица пишется прямо из массивов маршрутизатора
+void WriteRouteTable(const RouteTable& table, CodedOutputStream& output) {
+    using transport_catalog_serialize::RoutesData;
+    const uint32_t vertex_count = static_cast<uint32_t>(table.vertex_count);
+    constexpr int weights_field = std::is_same_v<transport_router_::RouteWeight, float>
+            ? RoutesData::kFloatWeightsFieldNumber : RoutesData::kWeightsFieldNumber;
+    size_t routes_size = PackedFieldSize(weights_field, table.weights)
+            + PackedFieldSize(RoutesData::kPrevEdgesFieldNumber, table.prev_edges);
+    if (vertex_count > 0) {
+        routes_size += WireFormatLite::TagSize(RoutesData::kVertexCountFieldNumber, WireFormatLite::TYPE_UINT32)
+                + WireFormatLite::UInt32Size(vertex_count);
+    }
+    const int data_field = transport_catalog_serialize::Router::kDataFieldNumber;
+    const size_t router_size = WireFormatLite::TagSize(data_field, WireFormatLite::TYPE_MESSAGE)
+            + CodedOutputStream::VarintSize64(routes_size) + routes_size;
+
+    WireFormatLite::WriteTag(transport_catalog_serialize::AllData::kRouterDataFieldNumber,
+                             WireFormatLite::WIRETYPE_LENGTH_DELIMITED, &output);
+    output.WriteVarint64(router_size);
+    WireFormatLite::WriteTag(data_field, WireFormatLite::WIRETYPE_LENGTH_DELIMITED, &output);
+    output.WriteVarint64(routes_size);
+    if (vertex_count > 0) {
+        WireFormatLite::WriteUInt32(RoutesData::kVertexCountFieldNumber, vertex_count, &output);
+    }
+    WritePackedField(weights_field, table.weights, output);
+    WritePackedField(RoutesData::kPrevEdgesFieldNumber, table.prev_edges, output);
+}
+
+}
+
+//снапшот пишется по полям AllData: каждое сообщение создаётся, записывается и освобождается
+//до следующего, поэтому в памяти одновременно живёт только одна часть снапшота
 size_t Serializator::Serialize(bool with_graph) const
  {
-    transport_catalog_serialize::AllData all_data;
-    *all_data.mutable_catalog() = catalog_.Serialize();
-    *all_data.mutable_render_settings() = renderer_.Serialize();
-    *all_data.mutable_router_data() = transport_router_.Serialize(with_graph);
-
+    if (format_ == SnapshotFormat::FLAT) {
+        return SerializeFlat(with_graph);
+    }
     std::ofstream out (path_to_serialize_, std::ios::binary | std::ios::trunc);
-    all_data.SerializePartialToOstream(&out);
+    {
+        google::protobuf::io::OstreamOutputStream raw_output(&out);
+        CodedOutputStream output(&raw_output);
+        using transport_catalog_serialize::AllData;
+        WriteMessageField(AllData::kCatalogFieldNumber, catalog_.Serialize(), output);
+        WriteMessageField(AllData::kRenderSettingsFieldNumber, renderer_.Serialize(), output);
+        WriteMessageField(AllData::kRouterDataFieldNumber, transport_router_.Serialize(with_graph), output);
+        if (const std::optional<RouteTable> table = transport_router_.GetRouteTable()) {
+            WriteRouteTable(*table, output);
+        }
+    }
+    out.close();
     return std::filesystem::file_size(path_to_serialize_);
 }
 
-bool Serializator::Deserialize(bool with_graph) {
+bool Serializator::Deserialize(bool with_graph, SnapshotSections sections) {
+    if (flat::MappedSnapshot::IsFlat(path_to_serialize_)) {
+        return DeserializeFlat(sections);
+    }
     transport_catalog_serialize::AllData all_data;
     std::ifstream in (path_to_serialize_, std::ios::binary);
+    google::protobuf::io::IstreamInputStream raw_input(&in);
+    google::protobuf::io::CodedInputStream input(&raw_input);
 
-    all_data.ParseFromIstream(&in);
+    //поля AllData разбираются только для нужных частей, остальные пропускаются без разбора
+    while (const uint32_t tag = input.ReadTag()) {
+        google::protobuf::MessageLite* field = nullptr;
+        switch (WireFormatLite::GetTagFieldNumber(tag)) {
+        case transport_catalog_serialize::AllData::kCatalogFieldNumber:
+            field = all_data.mutable_catalog();
+            break;
+        case transport_catalog_serialize::AllData::kRenderSettingsFieldNumber:
+            field = sections.render_settings ? all_data.mutable_render_settings() : nullptr;
+            break;
+        case transport_catalog_serialize::AllData::kRouterDataFieldNumber:
+            field = sections.router ? all_data.mutable_router_data() : nullptr;
+            break;
+        }
+        const bool parsed = field && WireFormatLite::GetTagWireType(tag) == WireFormatLite::WIRETYPE_LENGTH_DELIMITED
+                ? WireFormatLite::ReadMessage(&input, field)
+                : WireFormatLite::SkipField(&input, tag);
+        if (!parsed) {
+            throw std::invalid_argument("Snapshot is corrupted"s);
+        }
+    }
     catalog_.Deserialize(*all_data.mutable_catalog());
-    renderer_.Deserialize(*all_data.mutable_render_settings());
-    transport_router_.Deserialize(*all_data.mutable_router_data(), with_graph);
+    if (sections.render_settings) {
+        renderer_.Deserialize(*all_data.mutable_render_settings());
+    }
+    if (sections.router) {
+        transport_router_.Deserialize(*all_data.mutable_router_data(), with_graph);
+    }
     return true;
 }
+
+//плоский снапшот собирается из тех же сообщений, что и protobuf, поэтому содержимое форматов совпадает
+size_t Serializator::SerializeFlat(bool with_graph) const {
+    using transport_router_::RouteWeight;
+    flat::Writer writer;
+    //справочник: в Catalog остановки автобусов и расстояний — позиции в отсортированном по имени списке,
+    //в плоском снапшоте — номера остановок (vertex_id)
+    const transport_catalog_serialize::Catalog catalog = catalog_.Serialize();
+    const auto& stops_in = catalog.stop_list().stop();
+    std::vector<uint32_t> by_name(stops_in.size());
+    std::iota(by_name.begin(), by_name.end(), 0);
+    std::sort(by_name.begin(), by_name.end(), [&stops_in](uint32_t lhs, uint32_t rhs) {
+        return stops_in[lhs].name() < stops_in[rhs].name();
+    });
+    std::string strings;
+    auto add_string = [&strings](const std::string& value, uint32_t& offset, uint32_t& size) {
+        offset = static_cast<uint32_t>(strings.size());
+        size = static_cast<uint32_t>(value.size());
+        strings += value;
+    };
+    std::vector<flat::Stop> stops(stops_in.size());
+    std::vector<uint32_t> stop_buses;
+    for (int i = 0; i < stops_in.size(); ++i) {
+        stops[i].latitude = stops_in[i].latitude();
+        stops[i].longitude = stops_in[i].longitude();
+        add_string(stops_in[i].name(), stops[i].name_offset, stops[i].name_size);
+        stops[i].buses_offset = static_cast<uint32_t>(stop_buses.size());
+        stops[i].buses_count = static_cast<uint32_t>(stops_in[i].buses_size());
+        stop_buses.insert(stop_buses.end(), stops_in[i].buses().begin(), stops_in[i].buses().end());
+    }
+    std::vector<flat::Bus> buses(catalog.bus_list().bus_size());
+    std::vector<uint32_t> bus_stops;
+    for (int i = 0; i < catalog.bus_list().bus_size(); ++i) {
+        const transport_catalog_serialize::Bus& bus = catalog.bus_list().bus(i);
+        add_string(bus.name(), buses[i].name_offset, buses[i].name_size);
+        buses[i].stops_offset = static_cast<uint32_t>(bus_stops.size());
+        buses[i].stops_count = static_cast<uint32_t>(bus.stop_size());
+        buses[i].route_type = bus.route_type();
+        buses[i].unique_stops = bus.unique_stops();
+        buses[i].distance = bus.distance();
+        buses[i].curvature = bus.curvature();
+        for (const uint32_t position : bus.stop()) {
+            bus_stops.push_back(by_name[position]);
+        }
+    }
+    std::vector<flat::Distance> distances;
+    distances.reserve(catalog.distance_list().distance_size());
+    for (const transport_catalog_serialize::Distance& distance : catalog.distance_list().distance()) {
+        distances.push_back({by_name[distance.index_from()], by_name[distance.index_to()], distance.distance()});
+    }
+    writer.AddSection(flat::SectionId::STRINGS, strings);
+    writer.AddSection(flat::SectionId::STOPS, stops);
+    writer.AddSection(flat::SectionId::BUSES, buses);
+    writer.AddSection(flat::SectionId::BUS_STOPS, bus_stops);
+    writer.AddSection(flat::SectionId::STOP_BUSES, stop_buses);
+    writer.AddSection(flat::SectionId::DISTANCES, distances);
+
+    const std::string render_settings = renderer_.Serialize().SerializeAsString();
+    writer.AddSection(flat::SectionId::RENDER_SETTINGS, render_settings);
+
+    //маршрутизатор
+    const transport_catalog_serialize::Router router = transport_router_.Serialize(with_graph);
+    const flat::RoutingSettings routing_settings{router.settings().bus_wait_time(),
+                                                 router.settings().bus_velocity(),
+                                                 static_cast<uint32_t>(router.settings().router_type()),
+                                                 static_cast<uint32_t>(router.settings().graph_model()),
+                                                 router.settings().route_cache_mb(),
+                                                 router.settings().report_expanded_vertices()};
+    writer.AddSection(flat::SectionId::ROUTING_SETTINGS, &routing_settings, 1);
+    std::vector<RouteWeight> graph_weights;
+    std::vector<flat::EdgeInfo> edges;
+    if (router.has_graph()) {
+        const transport_catalog_serialize::Graph& graph = router.graph();
+        writer.AddSection(flat::SectionId::GRAPH_OFFSETS, graph.offsets().data(), graph.offsets_size());
+        writer.AddSection(flat::SectionId::GRAPH_TARGETS, graph.targets().data(), graph.targets_size());
+        graph_weights = graph::LoadWeights<RouteWeight>(graph.weights(), graph.float_weights());
+        writer.AddSection(flat::SectionId::GRAPH_WEIGHTS, graph_weights);
+        const transport_catalog_serialize::EdgeInfoList& info = graph.info();
+        edges.reserve(info.stop_size());
+        for (int i = 0; i < info.stop_size(); ++i) {
+            edges.push_back({info.stop(i), info.bus(i), info.count(i), static_cast<uint32_t>(info.type(i))});
+        }
+        writer.AddSection(flat::SectionId::EDGE_INFO, edges);
+    }
+    //таблица маршрутов пишется прямо из массивов маршрутизатора
+    if (const std::optional<RouteTable> table = transport_router_.GetRouteTable()) {
+        writer.AddSection(flat::SectionId::ROUTE_WEIGHTS, table->weights.begin(),
+                          table->weights.end() - table->weights.begin());
+        writer.AddSection(flat::SectionId::ROUTE_PREV_EDGES, table->prev_edges.begin(),
+                          table->prev_edges.end() - table->prev_edges.begin());
+    }
+    std::string contraction_hierarchy;
+    if (router.has_contraction_hierarchy()) {
+        contraction_hierarchy = router.contraction_hierarchy().SerializeAsString();
+        writer.AddSection(flat::SectionId::CONTRACTION_HIERARCHY, contraction_hierarchy);
+    }
+    std::string hub_labels;
+    if (router.has_hub_labels()) {
+        hub_labels = router.hub_labels().SerializeAsString();
+        writer.AddSection(flat::SectionId::HUB_LABELS, hub_labels);
+    }
+    return writer.Write(path_to_serialize_, sizeof(RouteWeight));
+}
+
+bool Serializator::DeserializeFlat(SnapshotSections sections) {
+    using transport_router_::RouteWeight;
+    snapshot_ = std::make_unique<flat::MappedSnapshot>(path_to_serialize_);
+    const flat::MappedSnapshot& snapshot = *snapshot_;
+    const std::string_view strings = snapshot.GetBytes(flat::SectionId::STRINGS);
+    auto get_string = [&strings](uint32_t offset, uint32_t size) {
+        if (offset > strings.size() || size > strings.size() - offset) {
+            throw std::invalid_argument("Flat snapshot string is out of range"s);
+        }
+        return strings.substr(offset, size);
+    };
+
+    //подмассив [offset, offset + count) секции; выход за её границы — ошибка снапшота
+    auto get_slice = [](ranges::Range<const uint32_t*> section, uint32_t offset, uint32_t count) {
+        const size_t size = section.end() - section.begin();
+        if (offset > size || count > size - offset) {
+            throw std::invalid_argument("Flat snapshot reference is out of range"s);
+        }
+        return ranges::Range<const uint32_t*>{section.begin() + offset, section.begin() + offset + count};
+    };
+
+    //справочник: остановки добавляются в порядке vertex_id, автобусы — в порядке Bus::id,
+    //статистика автобусов и списки автобусов остановок присваиваются без пересчёта
+    const auto stops = snapshot.GetArray<flat::Stop>(flat::SectionId::STOPS);
+    for (const flat::Stop& stop : stops) {
+        catalog_.AddStop(get_string(stop.name_offset, stop.name_size), {stop.latitude, stop.longitude});
+    }
+    const size_t stop_count = stops.end() - stops.begin();
+    auto get_stop = [this, stop_count](uint32_t id) {
+        if (id >= stop_count) {
+            throw std::invalid_argument("Flat snapshot stop id is out of range"s);
+        }
+        return catalog_.GetStopById(id);
+    };
+    for (const flat::Distance& distance : snapshot.GetArray<flat::Distance>(flat::SectionId::DISTANCES)) {
+        catalog_.SetDistance(get_stop(distance.from)->name, get_stop(distance.to)->name,
+                             static_cast<int>(distance.distance));
+    }
+    const auto bus_stops = snapshot.GetArray<uint32_t>(flat::SectionId::BUS_STOPS);
+    for (const flat::Bus& bus : snapshot.GetArray<flat::Bus>(flat::SectionId::BUSES)) {
+        std::vector<const domain::Stop*> stops_in_bus;
+        stops_in_bus.reserve(bus.stops_count * 2);
+        for (const uint32_t stop_id : get_slice(bus_stops, bus.stops_offset, bus.stops_count)) {
+            stops_in_bus.push_back(get_stop(stop_id));
+        }
+        catalog_.RestoreBus(get_string(bus.name_offset, bus.name_size), std::move(stops_in_bus), bus.route_type != 0,
+                            static_cast<int>(bus.unique_stops), static_cast<int>(bus.distance), bus.curvature);
+    }
+    const auto stop_buses = snapshot.GetArray<uint32_t>(flat::SectionId::STOP_BUSES);
+    for (uint32_t stop_id = 0; stop_id < stop_count; ++stop_id) {
+        const flat::Stop& stop = stops.begin()[stop_id];
+        if (stop.buses_count > 0) {
+            catalog_.RestoreStopBuses(stop_id, get_slice(stop_buses, stop.buses_offset, stop.buses_count));
+        }
+    }
+
+    if (sections.render_settings) {
+        const std::string_view render_bytes = snapshot.GetBytes(flat::SectionId::RENDER_SETTINGS);
+        transport_catalog_serialize::RenderSettings render_settings;
+        if (!render_settings.ParseFromArray(render_bytes.data(), static_cast<int>(render_bytes.size()))) {
+            throw std::invalid_argument("Flat snapshot render settings are corrupted"s);
+        }
+        renderer_.Deserialize(render_settings);
+    }
+    if (!sections.router) {
+        return true;
+    }
+
+    //маршрутизатор: веса читаются на месте, поэтому тип весов сборки должен совпадать со снапшотом
+    const auto settings = snapshot.GetArray<flat::RoutingSettings>(flat::SectionId::ROUTING_SETTINGS);
+    if (settings.end() - settings.begin() != 1) {
+        throw std::invalid_argument("Flat snapshot has no routing settings"s);
+    }
+    const flat::RoutingSettings& routing_settings = *settings.begin();
+    transport_router_::FlatRouterData router_data;
+    router_data.settings = {routing_settings.bus_wait_time,
+                            routing_settings.bus_velocity,
+                            static_cast<transport_router_::RouterType>(routing_settings.router_type),
+                            routing_settings.report_expanded_vertices != 0,
+                            static_cast<transport_router_::GraphModel>(routing_settings.graph_model),
+                            routing_settings.route_cache_mb};
+    if ((snapshot.HasSection(flat::SectionId::GRAPH_WEIGHTS) || snapshot.HasSection(flat::SectionId::ROUTE_WEIGHTS))
+            && snapshot.GetWeightSize() != sizeof(RouteWeight)) {
+        throw std::invalid_argument("Flat snapshot was written by a build with another weight type"s);
+    }
+    router_data.has_graph = snapshot.HasSection(flat::SectionId::GRAPH_OFFSETS);
+    if (router_data.has_graph) {
+        router_data.graph_offsets = snapshot.GetArray<uint32_t>(flat::SectionId::GRAPH_OFFSETS);
+        router_data.vertex_count = router_data.graph_offsets.end() - router_data.graph_offsets.begin() - 1;
+        router_data.graph_targets = snapshot.GetArray<uint32_t>(flat::SectionId::GRAPH_TARGETS);
+        router_data.graph_weights = snapshot.GetArray<RouteWeight>(flat::SectionId::GRAPH_WEIGHTS);
+        const auto edges = snapshot.GetArray<flat::EdgeInfo>(flat::SectionId::EDGE_INFO);
+        const size_t edge_count = router_data.graph_targets.end() - router_data.graph_targets.begin();
+        if (static_cast<size_t>(router_data.graph_weights.end() - router_data.graph_weights.begin()) != edge_count
+                || static_cast<size_t>(edges.end() - edges.begin()) != edge_count) {
+            throw std::invalid_argument("Flat snapshot graph sections have different sizes"s);
+        }
+        router_data.edges.reserve(edges.end() - edges.begin());
+        //номера остановок и автобусов проверяются по справочнику в TransportRouter::DeserializeFlat
+        for (const flat::EdgeInfo& edge : edges) {
+            router_data.edges.push_back({edge.stop, edge.bus, edge.count,
+                                         static_cast<transport_router_::EdgeType>(edge.type)});
+        }
+    }
+    router_data.route_table = {snapshot.GetArray<RouteWeight>(flat::SectionId::ROUTE_WEIGHTS),
+                               snapshot.GetArray<uint32_t>(flat::SectionId::ROUTE_PREV_EDGES)};
+    transport_catalog_serialize::ContractionHierarchy contraction_hierarchy;
+    if (snapshot.HasSection(flat::SectionId::CONTRACTION_HIERARCHY)) {
+        const std::string_view bytes = snapshot.GetBytes(flat::SectionId::CONTRACTION_HIERARCHY);
+        if (!contraction_hierarchy.ParseFromArray(bytes.data(), static_cast<int>(bytes.size()))) {
+            throw std::invalid_argument("Flat snapshot contraction hierarchy is corrupted"s);
+        }
+        router_data.contraction_hierarchy = &contraction_hierarchy;
+    }
+    transport_catalog_serialize::HubLabels hub_labels;
+    if (snapshot.HasSection(flat::SectionId::HUB_LABELS)) {
+        const std::string_view bytes = snapshot.GetBytes(flat::SectionId::HUB_LABELS);
+        if (!hub_labels.ParseFromArray(bytes.data(), static_cast<int>(bytes.size()))) {
+            throw std::invalid_argument("Flat snapshot hub labels are corrupted"s);
+        }
+        router_data.hub_labels = &hub_labels;
+    }
+    return transport_router_.DeserializeFlat(std::move(router_data));
+}
 }
@@ -0,0 +1,181 @@
+#pragma once
+#include "graph.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+//Двунаправленный Дейкстра: прямой поиск из from по рёбрам графа и обратный из to по обратной
+//смежности (строится один раз в формате CSR). Предобработки и хранения в снапшоте не требует.
+template <typename Weight>
+class BidirectionalDijkstraRouter {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+    using QueueItem = std::pair<Weight, VertexId>;
+    using Queue = std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>>;
+
+    static constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+
+public:
+    using RouteInfo = graph::RouteInfo<Weight>;
+
+    explicit BidirectionalDijkstraRouter(const Graph& graph);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+
+    //число вершин, извлечённых из очередей последним запросом (в обоих направлениях)
+    size_t GetExpandedVertexCount() const {
+        return expanded_vertices_;
+    }
+
+private:
+    //одна сторона поиска
+    struct Search {
+        std::vector<Weight> weights;
+        std::vector<EdgeId> prev_edge;
+        std::vector<uint32_t> epoch;
+
+        bool IsReached(VertexId vertex, uint32_t current) const {
+            return epoch[vertex] == current;
+        }
+    };
+
+    static constexpr Weight ZERO_WEIGHT{};
+    const Graph& graph_;
+    //входящие рёбра вершины v — reverse_edges_[reverse_offsets_[v], reverse_offsets_[v + 1])
+    std::vector<uint32_t> reverse_offsets_;
+    std::vector<uint32_t> reverse_edges_;
+
+    mutable Search forward_;
+    mutable Search backward_;
+    mutable uint32_t epoch_ = 0;
+    mutable size_t expanded_vertices_ = 0;
+};
+
+template <typename Weight>
+BidirectionalDijkstraRouter<Weight>::BidirectionalDijkstraRouter(const Graph& graph)
+    : graph_(graph)
+    , reverse_offsets_(graph.GetVertexCount() + 1, 0)
+    , reverse_edges_(graph.GetEdgeCount())
+{
+    const size_t vertex_count = graph.GetVertexCount();
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        const auto edge = graph.GetEdge(edge_id);
+        if (edge.weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+        ++reverse_offsets_[edge.to + 1];
+    }
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        reverse_offsets_[vertex + 1] += reverse_offsets_[vertex];
+    }
+    std::vector<uint32_t> positions(reverse_offsets_.begin(), reverse_offsets_.end() - 1);
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        reverse_edges_[positions[graph.GetEdge(edge_id).to]++] = static_cast<uint32_t>(edge_id);
+    }
+    for (Search* search : {&forward_, &backward_}) {
+        search->weights.resize(vertex_count);
+        search->prev_edge.resize(vertex_count);
+        search->epoch.assign(vertex_count, 0);
+    }
+}
+
+template <typename Weight>
+std::optional<typename BidirectionalDijkstraRouter<Weight>::RouteInfo> BidirectionalDijkstraRouter<Weight>::BuildRoute(
+        VertexId from, VertexId to) const {
+    if (from >= graph_.GetVertexCount() || to >= graph_.GetVertexCount()) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    if (++epoch_ == 0) {
+        std::fill(forward_.epoch.begin(), forward_.epoch.end(), 0);
+        std::fill(backward_.epoch.begin(), backward_.epoch.end(), 0);
+        epoch_ = 1;
+    }
+    expanded_vertices_ = 0;
+    Queue forward_queue;
+    Queue backward_queue;
+    std::optional<Weight> best;
+    VertexId meeting = from;
+    //вершина, достигнутая обеими сторонами, — кандидат в точку встречи
+    auto reach = [this, &best, &meeting](Search& search, Queue& queue, const Search& other,
+                                         VertexId vertex, Weight weight, EdgeId prev_edge) {
+        search.epoch[vertex] = epoch_;
+        search.weights[vertex] = weight;
+        search.prev_edge[vertex] = prev_edge;
+        queue.push({weight, vertex});
+        if (other.IsReached(vertex, epoch_) && (!best || weight + other.weights[vertex] < *best)) {
+            best = weight + other.weights[vertex];
+            meeting = vertex;
+        }
+    };
+    reach(forward_, forward_queue, backward_, from, ZERO_WEIGHT, NO_EDGE);
+    reach(backward_, backward_queue, forward_, to, ZERO_WEIGHT, NO_EDGE);
+
+    //прямой поиск идёт по исходящим рёбрам к edge.to, обратный — по входящим к edge.from
+    auto forward_step = [&]() {
+        const auto [weight, vertex] = forward_queue.top();
+        forward_queue.pop();
+        if (weight > forward_.weights[vertex]) {
+            return;
+        }
+        ++expanded_vertices_;
+        for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+            const auto edge = graph_.GetEdge(edge_id);
+            const Weight candidate_weight = weight + edge.weight;
+            if (!forward_.IsReached(edge.to, epoch_) || candidate_weight < forward_.weights[edge.to]) {
+                reach(forward_, forward_queue, backward_, edge.to, candidate_weight, edge_id);
+            }
+        }
+    };
+    auto backward_step = [&]() {
+        const auto [weight, vertex] = backward_queue.top();
+        backward_queue.pop();
+        if (weight > backward_.weights[vertex]) {
+            return;
+        }
+        ++expanded_vertices_;
+        for (uint32_t i = reverse_offsets_[vertex]; i < reverse_offsets_[vertex + 1]; ++i) {
+            const EdgeId edge_id = reverse_edges_[i];
+            const auto edge = graph_.GetEdge(edge_id);
+            const Weight candidate_weight = weight + edge.weight;
+            if (!backward_.IsReached(edge.from, epoch_) || candidate_weight < backward_.weights[edge.from]) {
+                reach(backward_, backward_queue, forward_, edge.from, candidate_weight, edge_id);
+            }
+        }
+    };
+    //остановка: сумма минимумов очередей не меньше лучшего найденного пути
+    //или одна из сторон исчерпана (тогда все пути через неё уже учтены)
+    while (!forward_queue.empty() && !backward_queue.empty()) {
+        if (best && forward_queue.top().first + backward_queue.top().first >= *best) {
+            break;
+        }
+        if (forward_queue.top().first <= backward_queue.top().first) {
+            forward_step();
+        } else {
+            backward_step();
+        }
+    }
+    if (!best) {
+        return std::nullopt;
+    }
+
+    std::vector<EdgeId> edges;
+    for (VertexId vertex = meeting; forward_.prev_edge[vertex] != NO_EDGE;
+         vertex = graph_.GetEdge(forward_.prev_edge[vertex]).from) {
+        edges.push_back(forward_.prev_edge[vertex]);
+    }
+    std::reverse(edges.begin(), edges.end());
+    for (VertexId vertex = meeting; backward_.prev_edge[vertex] != NO_EDGE;
+         vertex = graph_.GetEdge(backward_.prev_edge[vertex]).to) {
+        edges.push_back(backward_.prev_edge[vertex]);
+    }
+    return RouteInfo{*best, std::move(edges)};
+}
+}
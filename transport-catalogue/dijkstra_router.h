@@ -0,0 +1,235 @@
+#pragma once
+#include "graph.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+//Маршрутизатор, считающий кратчайший путь на каждый запрос (Дейкстра с бинарной кучей).
+//Не хранит таблицу V×V: память O(V+E), буферы переиспользуются между запросами.
+//С эвристикой (нижней оценкой остатка пути до цели) поиск становится A*.
+template <typename Weight>
+class DijkstraRouter {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+    //приоритет в очереди (вес + эвристика), вес, вершина
+    using QueueItem = std::tuple<Weight, Weight, VertexId>;
+
+public:
+    using RouteInfo = graph::RouteInfo<Weight>;
+    //нижняя оценка веса пути от вершины до цели запроса; должна быть согласованной
+    using Heuristic = std::function<Weight(VertexId)>;
+
+    explicit DijkstraRouter(const Graph& graph);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to, const Heuristic& heuristic = {}) const;
+
+    //веса кратчайших путей из from до каждой из targets одним поиском;
+    //поиск останавливается, когда из очереди извлечены все цели
+    std::vector<std::optional<Weight>> BuildWeights(VertexId from, const std::vector<VertexId>& targets) const;
+
+    //вершины, достижимые из from с весом пути не больше weight_limit, кроме самой from, в порядке
+    //извлечения из очереди (по неубыванию веса); поиск не раскрывает вершины за пределом
+    std::vector<std::pair<VertexId, Weight>> BuildReachable(VertexId from, Weight weight_limit) const;
+
+    //число вершин, извлечённых из очереди последним запросом
+    size_t GetExpandedVertexCount() const {
+        return expanded_vertices_;
+    }
+
+private:
+    //сбрасывает состояние вершин только для новой "эпохи" поиска, без O(V) очистки
+    void StartSearch() const {
+        if (++epoch_ == 0) {
+            std::fill(visited_epoch_.begin(), visited_epoch_.end(), 0);
+            std::fill(target_epoch_.begin(), target_epoch_.end(), 0);
+            epoch_ = 1;
+        }
+    }
+
+    bool IsReached(VertexId vertex) const {
+        return visited_epoch_[vertex] == epoch_;
+    }
+
+    void Reach(VertexId vertex, Weight weight, std::optional<EdgeId> prev_edge) const {
+        visited_epoch_[vertex] = epoch_;
+        weights_[vertex] = weight;
+        prev_edge_[vertex] = prev_edge;
+    }
+
+    static constexpr Weight ZERO_WEIGHT{};
+    const Graph& graph_;
+
+    mutable std::vector<Weight> weights_;
+    mutable std::vector<std::optional<EdgeId>> prev_edge_;
+    mutable std::vector<uint32_t> visited_epoch_;
+    //вершина — ещё не извлечённая цель BuildWeights в текущей эпохе
+    mutable std::vector<uint32_t> target_epoch_;
+    mutable uint32_t epoch_ = 0;
+    mutable size_t expanded_vertices_ = 0;
+};
+
+template <typename Weight>
+DijkstraRouter<Weight>::DijkstraRouter(const Graph& graph)
+    : graph_(graph)
+    , weights_(graph.GetVertexCount())
+    , prev_edge_(graph.GetVertexCount())
+    , visited_epoch_(graph.GetVertexCount(), 0)
+    , target_epoch_(graph.GetVertexCount(), 0)
+{
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+}
+
+template <typename Weight>
+std::optional<typename DijkstraRouter<Weight>::RouteInfo> DijkstraRouter<Weight>::BuildRoute(
+        VertexId from, VertexId to, const Heuristic& heuristic) const {
+    if (from >= graph_.GetVertexCount() || to >= graph_.GetVertexCount()) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    StartSearch();
+    expanded_vertices_ = 0;
+    auto priority = [&heuristic](VertexId vertex, Weight weight) {
+        return heuristic ? weight + heuristic(vertex) : weight;
+    };
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+    Reach(from, ZERO_WEIGHT, std::nullopt);
+    queue.push({priority(from, ZERO_WEIGHT), ZERO_WEIGHT, from});
+
+    while (!queue.empty()) {
+        const auto [key, weight, vertex] = queue.top();
+        queue.pop();
+        if (weight > weights_[vertex]) {
+            continue;   //устаревшая запись в очереди
+        }
+        ++expanded_vertices_;
+        if (vertex == to) {
+            break;
+        }
+        for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+            const auto edge = graph_.GetEdge(edge_id);
+            const Weight candidate_weight = weight + edge.weight;
+            if (!IsReached(edge.to) || candidate_weight < weights_[edge.to]) {
+                Reach(edge.to, candidate_weight, edge_id);
+                queue.push({priority(edge.to, candidate_weight), candidate_weight, edge.to});
+            }
+        }
+    }
+
+    if (!IsReached(to)) {
+        return std::nullopt;
+    }
+    std::vector<EdgeId> edges;
+    for (std::optional<EdgeId> edge_id = prev_edge_[to];
+         edge_id;
+         edge_id = prev_edge_[graph_.GetEdge(*edge_id).from])
+    {
+        edges.push_back(*edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+
+    return RouteInfo{weights_[to], std::move(edges)};
+}
+
+template <typename Weight>
+std::vector<std::optional<Weight>> DijkstraRouter<Weight>::BuildWeights(
+        VertexId from, const std::vector<VertexId>& targets) const {
+    if (from >= graph_.GetVertexCount()) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    StartSearch();
+    expanded_vertices_ = 0;
+    size_t remaining_targets = 0;
+    for (const VertexId target : targets) {
+        if (target >= graph_.GetVertexCount()) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+        if (target_epoch_[target] != epoch_) {
+            target_epoch_[target] = epoch_;
+            ++remaining_targets;
+        }
+    }
+    using Item = std::pair<Weight, VertexId>;
+    std::priority_queue<Item, std::vector<Item>, std::greater<Item>> queue;
+    Reach(from, ZERO_WEIGHT, std::nullopt);
+    queue.push({ZERO_WEIGHT, from});
+
+    while (!queue.empty() && remaining_targets > 0) {
+        const auto [weight, vertex] = queue.top();
+        queue.pop();
+        if (weight > weights_[vertex]) {
+            continue;   //устаревшая запись в очереди
+        }
+        ++expanded_vertices_;
+        if (target_epoch_[vertex] == epoch_) {
+            target_epoch_[vertex] = 0;
+            --remaining_targets;
+        }
+        for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+            const auto edge = graph_.GetEdge(edge_id);
+            const Weight candidate_weight = weight + edge.weight;
+            if (!IsReached(edge.to) || candidate_weight < weights_[edge.to]) {
+                Reach(edge.to, candidate_weight, edge_id);
+                queue.push({candidate_weight, edge.to});
+            }
+        }
+    }
+
+    std::vector<std::optional<Weight>> result;
+    result.reserve(targets.size());
+    for (const VertexId target : targets) {
+        result.push_back(IsReached(target) ? std::optional<Weight>(weights_[target]) : std::nullopt);
+    }
+    return result;
+}
+
+template <typename Weight>
+std::vector<std::pair<VertexId, Weight>> DijkstraRouter<Weight>::BuildReachable(
+        VertexId from, Weight weight_limit) const {
+    if (from >= graph_.GetVertexCount()) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    StartSearch();
+    expanded_vertices_ = 0;
+    std::vector<std::pair<VertexId, Weight>> result;
+    using Item = std::pair<Weight, VertexId>;
+    std::priority_queue<Item, std::vector<Item>, std::greater<Item>> queue;
+    Reach(from, ZERO_WEIGHT, std::nullopt);
+    queue.push({ZERO_WEIGHT, from});
+
+    while (!queue.empty()) {
+        const auto [weight, vertex] = queue.top();
+        queue.pop();
+        if (weight > weights_[vertex]) {
+            continue;   //устаревшая запись в очереди
+        }
+        ++expanded_vertices_;
+        if (vertex != from) {
+            result.push_back({vertex, weight});
+        }
+        for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+            const auto edge = graph_.GetEdge(edge_id);
+            const Weight candidate_weight = weight + edge.weight;
+            if (candidate_weight > weight_limit) {
+                continue;
+            }
+            if (!IsReached(edge.to) || candidate_weight < weights_[edge.to]) {
+                Reach(edge.to, candidate_weight, edge_id);
+                queue.push({candidate_weight, edge.to});
+            }
+        }
+    }
+    return result;
+}
+}
@@ -32,6 +32,7 @@ struct Bus {
     int unique_stops = 0;    //уникальные остановки
     int distance = 0;        //фактическая длина маршрута
     double curvature = 0.;   //извилистость
+    uint32_t id = 0;         //порядковый номер в справочнике
 
     bool operator==(const Bus &lhs) {
         return (this->name == lhs.name);
@@ -58,12 +59,23 @@ struct StopInput {
     geo::Coordinates coordinates;
 };
 
+struct DistanceInput {
+    std::string_view from;
+    std::string_view to;
+    int distance = 0;
+};
+
 struct query {
     int id;
     std::string type;
     std::string name;
     std::string from;
     std::string to;
+    //RouteMatrix: списки остановок отправления и назначения
+    std::vector<std::string> sources{};
+    std::vector<std::string> targets{};
+    //Isochrone: предел времени в пути, мин
+    double time_limit = 0.;
 };
 
 struct StopOutput {
@@ -87,7 +99,22 @@ struct RouteOutput {
     const Stop* to;
 };
 
-using OutputAnswers = std::variant<int, StopOutput, BusOutput, MapOutput, RouteOutput>;
+//матрица времени в пути: строка на каждую остановку sources, столбец на каждую targets
+struct RouteMatrixOutput {
+    int id;
+    std::vector<const Stop*> sources;
+    std::vector<const Stop*> targets;
+};
+
+//остановки, достижимые из from не дольше чем за time_limit
+struct IsochroneOutput {
+    int id;
+    const Stop* from;
+    double time_limit;
+};
+
+using OutputAnswers = std::variant<int, StopOutput, BusOutput, MapOutput, RouteOutput, RouteMatrixOutput,
+                                   IsochroneOutput>;
 
 class Hasher {
 public:
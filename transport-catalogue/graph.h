@@ -1,7 +1,12 @@
 #pragma once
 #include "ranges.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <cstdlib>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
 #include <vector>
 #include <graph.pb.h>
 
@@ -17,12 +22,40 @@ struct Edge {
     Weight weight;
 };
 
+//веса в снапшоте пишутся в поле своего типа: float — в поле float (4 байта на вес), иначе в double
+template <typename Weights, typename DoubleField, typename FloatField>
+void StoreWeights(const Weights& weights, DoubleField* doubles, FloatField* floats) {
+    if constexpr (std::is_same_v<std::decay_t<decltype(*weights.begin())>, float>) {
+        floats->Add(weights.begin(), weights.end());
+    } else {
+        doubles->Add(weights.begin(), weights.end());
+    }
+}
+
+//читаются из непустого поля, так что снапшот совместим между сборками с double и float
+template <typename Weight, typename DoubleField, typename FloatField>
+std::vector<Weight> LoadWeights(const DoubleField& doubles, const FloatField& floats) {
+    if (floats.empty()) {
+        return {doubles.begin(), doubles.end()};
+    }
+    return {floats.begin(), floats.end()};
+}
+
+template <typename Weight>
+struct RouteInfo {
+    Weight weight;
+    std::vector<EdgeId> edges;
+};
+
+//Граф хранится в два этапа: при построении рёбра только добавляются в конец, затем Freeze()
+//упорядочивает их по исходной вершине и переводит граф в формат CSR: смещения по вершинам,
+//цели и веса рёбер — плотными массивами. После Freeze() id ребра — его позиция в этих массивах,
+//добавлять рёбра нельзя, а обходить исходящие рёбра — можно.
 template <typename Weight>
 class DirectedWeightedGraph
 {
 private:
-    using IncidenceList = std::vector<EdgeId>;
-    using IncidentEdgesRange = ranges::Range<typename IncidenceList::const_iterator>;
+    using IncidentEdgesRange = ranges::Range<ranges::CountingIterator<EdgeId>>;
 
 public:
     DirectedWeightedGraph() = default;
@@ -30,70 +63,193 @@ public:
     EdgeId AddEdge(const Edge<Weight>& edge);
 
     void SetVertexCount(size_t vertex_count);
+    //переводит граф в CSR; возвращает новые id рёбер по старым (в порядке AddEdge)
+    std::vector<EdgeId> Freeze();
+    bool IsFrozen() const {
+        return !offsets_.empty();
+    }
 
     size_t GetVertexCount() const;
     size_t GetEdgeCount() const;
 
-    const Edge<Weight>& GetEdge(EdgeId edge_id) const;
+    Edge<Weight> GetEdge(EdgeId edge_id) const;
+    //вес ребра можно менять и после Freeze(): структура графа при этом не меняется
+    void SetEdgeWeight(EdgeId edge_id, Weight weight);
     IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
     transport_catalog_serialize::Graph GetSerializeData() const;
+    //восстанавливает замороженный граф из массивов CSR
+    void SetSerializeData(const transport_catalog_serialize::Graph& graph);
+    //то же из массивов плоского снапшота (копированием блоков)
+    void SetFlatData(size_t vertex_count, ranges::Range<const uint32_t*> offsets,
+                     ranges::Range<const uint32_t*> targets, ranges::Range<const Weight*> weights);
 
 private:
-    std::vector<Edge<Weight>> edges_;
-    std::vector<IncidenceList> incidence_lists_;
+    //проверяет массивы CSR (в том числе цели рёбер) и восстанавливает по offsets_ исходные вершины рёбер
+    void RestoreSources();
+
+    size_t vertex_count_ = 0;
+    //исходные вершины рёбер; после Freeze() переставлены вместе с targets_ и weights_,
+    //чтобы GetEdge не искал вершину по offsets_
+    std::vector<uint32_t> sources_;
+    std::vector<uint32_t> targets_;
+    std::vector<Weight> weights_;
+    //рёбра вершины v — [offsets_[v], offsets_[v + 1])
+    std::vector<uint32_t> offsets_;
 };
 
 template <typename Weight>
 transport_catalog_serialize::Graph DirectedWeightedGraph<Weight>::GetSerializeData() const
 {
     transport_catalog_serialize::Graph graph;
-    for (const Edge<double>& edge : edges_) {
-        transport_catalog_serialize::Edge edge_out;
-        edge_out.set_from(static_cast<uint32_t>(edge.from));
-        edge_out.set_to(static_cast<uint32_t>(edge.to));
-        edge_out.set_weight(edge.weight);
-        graph.add_edges();
-        *graph.mutable_edges(graph.edges_size()-1) = edge_out;
-    }
+    graph.set_vertex_count(static_cast<uint32_t>(GetVertexCount()));
+    graph.mutable_offsets()->Add(offsets_.begin(), offsets_.end());
+    graph.mutable_targets()->Add(targets_.begin(), targets_.end());
+    StoreWeights(weights_, graph.mutable_weights(), graph.mutable_float_weights());
     return graph;
 }
 
 template <typename Weight>
-DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count)
-    : incidence_lists_(vertex_count) {
+void DirectedWeightedGraph<Weight>::SetSerializeData(const transport_catalog_serialize::Graph& graph)
+{
+    vertex_count_ = graph.vertex_count();
+    offsets_.assign(graph.offsets().begin(), graph.offsets().end());
+    targets_.assign(graph.targets().begin(), graph.targets().end());
+    weights_ = LoadWeights<Weight>(graph.weights(), graph.float_weights());
+    RestoreSources();
+}
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::SetFlatData(size_t vertex_count, ranges::Range<const uint32_t*> offsets,
+                                                ranges::Range<const uint32_t*> targets,
+                                                ranges::Range<const Weight*> weights)
+{
+    vertex_count_ = vertex_count;
+    offsets_.assign(offsets.begin(), offsets.end());
+    targets_.assign(targets.begin(), targets.end());
+    weights_.assign(weights.begin(), weights.end());
+    RestoreSources();
+}
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::RestoreSources()
+{
+    if (offsets_.size() != vertex_count_ + 1 || offsets_.front() != 0 || targets_.size() != weights_.size()
+            || offsets_.back() != targets_.size()) {
+        throw std::invalid_argument("Inconsistent graph data");
+    }
+    sources_.resize(targets_.size());
+    for (size_t vertex = 0; vertex < vertex_count_; ++vertex) {
+        if (offsets_[vertex] > offsets_[vertex + 1]) {
+            throw std::invalid_argument("Inconsistent graph data");
+        }
+        std::fill(sources_.begin() + offsets_[vertex], sources_.begin() + offsets_[vertex + 1],
+                  static_cast<uint32_t>(vertex));
+    }
+    if (std::any_of(targets_.begin(), targets_.end(), [this](uint32_t target) { return target >= vertex_count_; })) {
+        throw std::invalid_argument("Inconsistent graph data");
+    }
+}
+
+template <typename Weight>
+DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count) {
+    SetVertexCount(vertex_count);
 }
 
 template <typename Weight>
 void DirectedWeightedGraph<Weight>::SetVertexCount(size_t vertex_count) {
-    incidence_lists_.resize(vertex_count);
+    if (IsFrozen()) {
+        throw std::logic_error("Graph is frozen");
+    }
+    if (vertex_count > std::numeric_limits<uint32_t>::max()) {
+        throw std::length_error("Too many vertices");
+    }
+    vertex_count_ = vertex_count;
 }
 
 template <typename Weight>
 EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight>& edge) {
-    edges_.push_back(edge);
-    const EdgeId id = edges_.size() - 1;
-    incidence_lists_.at(edge.from).push_back(id);
-    return id;
+    if (IsFrozen()) {
+        throw std::logic_error("Graph is frozen");
+    }
+    if (edge.from >= vertex_count_ || edge.to >= vertex_count_) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    sources_.push_back(static_cast<uint32_t>(edge.from));
+    targets_.push_back(static_cast<uint32_t>(edge.to));
+    weights_.push_back(edge.weight);
+    return targets_.size() - 1;
+}
+
+template <typename Weight>
+std::vector<EdgeId> DirectedWeightedGraph<Weight>::Freeze() {
+    if (IsFrozen()) {
+        throw std::logic_error("Graph is frozen");
+    }
+    if (targets_.size() > std::numeric_limits<uint32_t>::max()) {
+        throw std::length_error("Too many edges");
+    }
+    //устойчивая сортировка подсчётом по исходной вершине
+    offsets_.assign(vertex_count_ + 1, 0);
+    for (const uint32_t source : sources_) {
+        ++offsets_[source + 1];
+    }
+    for (size_t vertex = 0; vertex < vertex_count_; ++vertex) {
+        offsets_[vertex + 1] += offsets_[vertex];
+    }
+    std::vector<EdgeId> new_ids(targets_.size());
+    std::vector<uint32_t> next(offsets_.begin(), offsets_.end() - 1);
+    for (EdgeId edge_id = 0; edge_id < sources_.size(); ++edge_id) {
+        new_ids[edge_id] = next[sources_[edge_id]]++;
+    }
+    std::vector<uint32_t> sources(sources_.size());
+    std::vector<uint32_t> targets(targets_.size());
+    std::vector<Weight> weights(weights_.size());
+    for (EdgeId edge_id = 0; edge_id < new_ids.size(); ++edge_id) {
+        sources[new_ids[edge_id]] = sources_[edge_id];
+        targets[new_ids[edge_id]] = targets_[edge_id];
+        weights[new_ids[edge_id]] = weights_[edge_id];
+    }
+    sources_ = std::move(sources);
+    targets_ = std::move(targets);
+    weights_ = std::move(weights);
+    return new_ids;
 }
 
 template <typename Weight>
 size_t DirectedWeightedGraph<Weight>::GetVertexCount() const {
-    return incidence_lists_.size();
+    return vertex_count_;
 }
 
 template <typename Weight>
 size_t DirectedWeightedGraph<Weight>::GetEdgeCount() const {
-    return edges_.size();
+    return targets_.size();
+}
+
+template <typename Weight>
+Edge<Weight> DirectedWeightedGraph<Weight>::GetEdge(EdgeId edge_id) const {
+    if (edge_id >= targets_.size()) {
+        throw std::out_of_range("Edge id is out of range");
+    }
+    return {sources_[edge_id], targets_[edge_id], weights_[edge_id]};
 }
 
 template <typename Weight>
-const Edge<Weight>& DirectedWeightedGraph<Weight>::GetEdge(EdgeId edge_id) const {
-    return edges_.at(edge_id);
+void DirectedWeightedGraph<Weight>::SetEdgeWeight(EdgeId edge_id, Weight weight) {
+    if (edge_id >= weights_.size()) {
+        throw std::out_of_range("Edge id is out of range");
+    }
+    weights_[edge_id] = weight;
 }
 
 template <typename Weight>
 typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
 DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
-    return ranges::AsRange(incidence_lists_.at(vertex));
+    if (!IsFrozen()) {
+        throw std::logic_error("Graph is not frozen");
+    }
+    if (vertex >= vertex_count_) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    return ranges::AsCountingRange<EdgeId>(offsets_[vertex], offsets_[vertex + 1]);
+}
 }
-}  
@@ -0,0 +1,100 @@
+//Бенчмарк арены документа: json::Load файла в дерево из кучи и из арены — время разбора, время
+//разрушения документа и число выделений памяти. Собирается с -DTRANSPORT_CATALOGUE_BENCHMARK=ON,
+//запуск: json_arena_benchmark base.json
+#include "json.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <memory>
+
+namespace {
+
+//счётчик выделений через глобальный operator new: учитываются и узлы дерева, и длинные строки.
+//new_delete_resource выделяет память через выровненную форму operator new, она заменена тоже
+size_t allocation_count = 0;
+
+constexpr int REPEAT_COUNT = 5;
+
+struct Result {
+    double load_seconds = 0;
+    double teardown_seconds = 0;
+    size_t allocations = 0;
+};
+
+Result Measure(const char* path, bool use_arena) {
+    Result best;
+    for (int i = 0; i < REPEAT_COUNT; ++i) {
+        std::ifstream input(path, std::ios::binary);
+        if (!input) {
+            throw std::runtime_error("Cannot open "s + path);
+        }
+        const size_t allocations_before = allocation_count;
+        const auto start = std::chrono::steady_clock::now();
+        //Document не перемещается, поэтому создаётся в куче прямо из результата Load (+1 выделение)
+        std::unique_ptr<json::Document> document(new json::Document(json::Load(input, use_arena)));
+        const auto loaded = std::chrono::steady_clock::now();
+        const size_t allocations = allocation_count - allocations_before;
+        document.reset();
+        const auto destroyed = std::chrono::steady_clock::now();
+
+        const Result result{std::chrono::duration<double>(loaded - start).count(),
+                            std::chrono::duration<double>(destroyed - loaded).count(), allocations};
+        if (i == 0 || result.load_seconds + result.teardown_seconds < best.load_seconds + best.teardown_seconds) {
+            best = result;
+        }
+    }
+    return best;
+}
+
+void Report(std::string_view name, const Result& result) {
+    std::cout << name << ": load "sv << result.load_seconds << " s, teardown "sv << result.teardown_seconds
+              << " s, allocations "sv << result.allocations << '\n';
+}
+
+}
+
+void* operator new(size_t size) {
+    ++allocation_count;
+    if (void* pointer = std::malloc(size == 0 ? 1 : size)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    std::free(pointer);
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    ++allocation_count;
+    const size_t align = static_cast<size_t>(alignment);
+    //aligned_alloc требует размер, кратный выравниванию
+    if (void* pointer = std::aligned_alloc(align, (size + align - 1) / align * align + (size == 0 ? align : 0))) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept {
+    std::free(pointer);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        std::cerr << "Usage: json_arena_benchmark file.json\n"sv;
+        return 1;
+    }
+    Report("heap"sv, Measure(argv[1], false));
+    Report("arena"sv, Measure(argv[1], true));
+}
@@ -0,0 +1,146 @@
+//Микробенчмарк чисел в json.cpp: чтение from_chars против stod/stoi и печать to_chars против ostream <<,
+//а также json::Load и json::Print документа из чисел. Собирается с -DTRANSPORT_CATALOGUE_BENCHMARK=ON
+#include "json.h"
+
+#include <charconv>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr size_t VALUE_COUNT = 1'000'000;
+constexpr int REPEAT_COUNT = 5;
+
+//лучшее время из REPEAT_COUNT запусков, секунды
+template <typename Function>
+double Measure(Function function) {
+    double best = 0;
+    for (int i = 0; i < REPEAT_COUNT; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        function();
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (i == 0 || seconds < best) {
+            best = seconds;
+        }
+    }
+    return best;
+}
+
+void Report(std::string_view name, double old_seconds, double new_seconds) {
+    std::cout << name << ": "sv << old_seconds << " s -> "sv << new_seconds << " s ("sv
+              << old_seconds / new_seconds << "x)\n"sv;
+}
+
+//значения, как во входных данных: координаты остановок и расстояния
+struct Values {
+    std::vector<double> coordinates;
+    std::vector<int> distances;
+    std::vector<std::string> coordinate_texts;
+    std::vector<std::string> distance_texts;
+};
+
+Values MakeValues() {
+    Values values;
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<double> coordinate(-90.0, 90.0);
+    std::uniform_int_distribution<int> distance(1, 1'000'000);
+    for (size_t i = 0; i < VALUE_COUNT; ++i) {
+        values.coordinates.push_back(coordinate(generator));
+        values.distances.push_back(distance(generator));
+        char buffer[32];
+        values.coordinate_texts.emplace_back(buffer, std::to_chars(buffer, buffer + sizeof(buffer), values.coordinates.back()).ptr);
+        values.distance_texts.push_back(std::to_string(values.distances.back()));
+    }
+    return values;
+}
+
+void BenchmarkParsing(const Values& values) {
+    volatile double sink = 0;
+    Report("parse double"sv,
+           Measure([&] {
+               double sum = 0;
+               for (const std::string& text : values.coordinate_texts) {
+                   sum += std::stod(text);
+               }
+               sink = sum;
+           }),
+           Measure([&] {
+               double sum = 0;
+               for (const std::string& text : values.coordinate_texts) {
+                   double value = 0;
+                   std::from_chars(text.data(), text.data() + text.size(), value);
+                   sum += value;
+               }
+               sink = sum;
+           }));
+    Report("parse int"sv,
+           Measure([&] {
+               long long sum = 0;
+               for (const std::string& text : values.distance_texts) {
+                   sum += std::stoi(text);
+               }
+               sink = static_cast<double>(sum);
+           }),
+           Measure([&] {
+               long long sum = 0;
+               for (const std::string& text : values.distance_texts) {
+                   int value = 0;
+                   std::from_chars(text.data(), text.data() + text.size(), value);
+                   sum += value;
+               }
+               sink = static_cast<double>(sum);
+           }));
+}
+
+void BenchmarkPrinting(const Values& values) {
+    Report("print double"sv,
+           Measure([&] {
+               std::ostringstream out;
+               for (const double value : values.coordinates) {
+                   out << value << ' ';
+               }
+           }),
+           Measure([&] {
+               std::ostringstream out;
+               char buffer[32];
+               for (const double value : values.coordinates) {
+                   out.write(buffer, std::to_chars(buffer, buffer + sizeof(buffer), value).ptr - buffer);
+                   out.put(' ');
+               }
+           }));
+}
+
+//json::Load и json::Print массива из чисел — путь, которым числа идут в программе
+void BenchmarkDocument(const Values& values) {
+    std::string text = "["s;
+    for (size_t i = 0; i < VALUE_COUNT; ++i) {
+        text += values.coordinate_texts[i];
+        text += ", "sv;
+        text += values.distance_texts[i];
+        text += i + 1 < VALUE_COUNT ? ", "sv : "]"sv;
+    }
+    json::Document document;
+    const double load_seconds = Measure([&] {
+        std::istringstream input(text);
+        document = json::Load(input);
+    });
+    const double print_seconds = Measure([&] {
+        std::ostringstream output;
+        json::Print(document, output);
+    });
+    std::cout << "json::Load: "sv << load_seconds << " s, json::Print: "sv << print_seconds << " s ("sv
+              << text.size() << " bytes)\n"sv;
+}
+
+}
+
+int main() {
+    const Values values = MakeValues();
+    BenchmarkParsing(values);
+    BenchmarkPrinting(values);
+    BenchmarkDocument(values);
+}
@@ -6,6 +6,8 @@
 #include "transport_router.h"
 #include "serialization.h"
 
+#include <unordered_set>
+
 namespace json_reader {
 	
 	class JsonReader {
@@ -17,19 +19,25 @@ namespace json_reader {
                              serialize::Serializator& serializ)
             : catalogue_(catalogue) , transport_router_(router), map_renderer_(map_renderer), serializator_(serializ){}
 
-		const std::vector<domain::BusInput> GetBuses()const;
-		const std::vector<domain::StopInput> GetStops()const;
-		const std::map<std::pair<std::string, std::string>, int> GetDistances()const;
+		const std::vector<domain::BusInput>& GetBuses()const;
+		const std::vector<domain::StopInput>& GetStops()const;
+		const std::vector<domain::DistanceInput>& GetDistances()const;
 		const std::vector<domain::query> GetQuery() const;
 
-		void LoadDocument(std::istream &input);
+		//Разбирает вход потоком, без дерева документа: base_requests сразу раскладываются по stops_,
+		//buses_ и distances_, остальные разделы собираются в небольшие деревья Node.
+		//add_stops — остановки добавляются в справочник по мере чтения и не буферизуются (make_base)
+		void LoadDocument(std::istream &input, bool add_stops = false);
 		void ReadDocument();
 
 		void PrintDocument(json::Document& document_answer, json::Builder& builder,
 			std::vector<domain::OutputAnswers> answers_);
 
 	private:
-		void ParseBase(const json::Node& node_);
+		class InputHandler;
+		//имена остановок из base_requests хранятся по одному разу, на них ссылаются buses_ и distances_
+		std::string_view AddName(std::string name);
+
 		void ParseStats(const json::Node& node_);
 		void ParseSettings(const json::Node& node_);
 		void ParseRoutingSettings(const json::Node& node_);
@@ -44,6 +52,8 @@ namespace json_reader {
 			json::Node operator() (domain::BusOutput& value);
 			json::Node operator() (domain::MapOutput& value);
 			json::Node operator() (domain::RouteOutput& value);
+			json::Node operator() (domain::RouteMatrixOutput& value);
+			json::Node operator() (domain::IsochroneOutput& value);
 			//печать строки ошибки
 			json::Node ErrorMassage(json::Builder& builder, int id);
 		private:
@@ -53,7 +63,8 @@ namespace json_reader {
 		std::vector<domain::BusInput> buses_; // маршруты(автобусы)
 		std::vector<domain::StopInput> stops_; // остановки
 		std::vector<domain::query> stats_; // запрос базы
-		std::map<std::pair<std::string, std::string>, int> distances_;// расстояние от остановки до остановки
+		std::vector<domain::DistanceInput> distances_;// расстояние от остановки до остановки
+		std::unordered_set<std::string> names_;
 
 		json::Document document_ = {};
 
@@ -12,7 +12,7 @@ using namespace std;
 using namespace std::literals;
 
 void PrintUsage(std::ostream& stream = std::cerr) {
-    stream << "Usage: transport_catalogue [make_base|process_requests]\n"sv;
+    stream << "Usage: transport_catalogue [make_base|update_base|process_requests]\n"sv;
 }
 
 int main(int argc, char* argv[]) {
@@ -37,11 +37,21 @@ int main(int argc, char* argv[]) {
     {
         transport_catalogue::TransportCatalogue transport_;
         RequestHandler request_handler(transport_,std::cin);
-        request_handler.ReadInputDocument();
+        //остановки попадают в справочник при чтении, расстояния и автобусы — в AddInfo
+        request_handler.ReadInputDocument(true);
         request_handler.AddInfo();
         request_handler.CreateGraph();
         request_handler.Serialize(saving_graph);
      
+    } else if (mode == "update_base"sv) {
+        //изменения базы (остановки, автобусы, road_distances) применяются к сохранённому снапшоту
+        transport_catalogue::TransportCatalogue transport_;
+        RequestHandler request_handler(transport_,std::cin);
+        request_handler.ReadInputDocument();
+        request_handler.Deserialize(saving_graph);
+        request_handler.UpdateInfo();
+        request_handler.Serialize(saving_graph);
+
     } else if (mode == "process_requests"sv) {
         //файл вывода
         //std::filebuf file;
@@ -52,7 +62,7 @@ int main(int argc, char* argv[]) {
         transport_catalogue::TransportCatalogue transport_;
         RequestHandler request_handler(transport_,std::cin,std::cout);//std::cin,std::cout
         request_handler.ReadInputDocument();
-        request_handler.Deserialize(saving_graph);
+        request_handler.DeserializeForRequests(saving_graph);
         request_handler.GetAnswers();
         request_handler.PrintAnswers();
         //file.close();
@@ -4,9 +4,9 @@
 
 using namespace std;
 
-void RequestHandler::ReadInputDocument()
+void RequestHandler::ReadInputDocument(bool add_stops)
 {
-	reader_.LoadDocument(input_);
+	reader_.LoadDocument(input_, add_stops);
 	reader_.ReadDocument();
 }
 
@@ -25,6 +25,34 @@ void RequestHandler::AddInfo()
 	AddBuses();
 }
 
+void RequestHandler::UpdateInfo()
+{
+	const auto& stops_ = reader_.GetStops();
+	std::for_each(stops_.begin(), stops_.end(), [&](const domain::StopInput& stop)
+	{
+		if (!db_.GetStopInfo(stop.name)) {
+			db_.AddStop(stop.name, stop.coordinates);
+		}
+	});
+	AddDistances();
+	AddBuses();
+	db_.UpdateBusStats();
+	router_.UpdateGraph();
+}
+
+bool RequestHandler::DeserializeForRequests(bool with_graph)
+{
+	serialize::SnapshotSections sections{ false, false };
+	for (const domain::query& stat : reader_.GetQuery()) {
+		if (stat.type == "Map"s) {
+			sections.render_settings = true;
+		} else if (stat.type == "Route"s || stat.type == "RouteMatrix"s || stat.type == "Isochrone"s) {
+			sections.router = true;
+		}
+	}
+	return serializator_.Deserialize(with_graph, sections);
+}
+
 void RequestHandler::RenderMapGlob()
 {
 	map_renderer_.Render(output_);
@@ -44,23 +72,22 @@ std::string RequestHandler::RenderMap()
 
 void RequestHandler::AddStops()
 {
-	auto stops_ = reader_.GetStops();
-	std::for_each(stops_.begin(), stops_.end(), [&](domain::StopInput& stop)
+	const auto& stops_ = reader_.GetStops();
+	std::for_each(stops_.begin(), stops_.end(), [&](const domain::StopInput& stop)
 	{ db_.AddStop(stop.name, stop.coordinates); });
 }
 
 void RequestHandler::AddBuses()
 {
-	auto buses_ = reader_.GetBuses();
-	std::for_each(buses_.begin(), buses_.end(), [&](domain::BusInput& bus)
+	auto& buses_ = reader_.GetBuses();
+	std::for_each(buses_.begin(), buses_.end(), [&](const domain::BusInput& bus)
 	{ db_.AddBus(bus.name, bus.stops, bus.is_roundtrip); });
 }
 
 void RequestHandler::AddDistances()
 {
-	auto distances_ = reader_.GetDistances();
-	for (auto& dis : distances_)
-		db_.SetDistance(dis.first.first, dis.first.second, dis.second);
+	for (const domain::DistanceInput& dis : reader_.GetDistances())
+		db_.SetDistance(dis.from, dis.to, dis.distance);
 }
 
 std::optional<const domain::Bus*> RequestHandler::GetBusStat(const std::string_view &bus_name) const
@@ -118,5 +145,34 @@ void RequestHandler::GetAnswers()
 			}
 			answers_.push_back(domain::RouteOutput({ stat.id, *from, *to }));
 		}
+		else if (stat.type == "RouteMatrix"s)
+		{
+			domain::RouteMatrixOutput output{ stat.id, {}, {} };
+			bool found = true;
+			for (const std::string& name : stat.sources) {
+				optional<const domain::Stop*> stop = db_.GetStopInfo(name);
+				found = found && stop;
+				output.sources.push_back(stop.value_or(nullptr));
+			}
+			for (const std::string& name : stat.targets) {
+				optional<const domain::Stop*> stop = db_.GetStopInfo(name);
+				found = found && stop;
+				output.targets.push_back(stop.value_or(nullptr));
+			}
+			if (!found) {
+				answers_.push_back(stat.id);
+				continue;
+			}
+			answers_.push_back(std::move(output));
+		}
+		else if (stat.type == "Isochrone"s)
+		{
+			optional<const domain::Stop*> from = db_.GetStopInfo(stat.from);
+			if (!from) {
+				answers_.push_back(stat.id);
+				continue;
+			}
+			answers_.push_back(domain::IsochroneOutput{ stat.id, *from, stat.time_limit });
+		}
 	}
 }
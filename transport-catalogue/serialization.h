@@ -2,11 +2,25 @@
 #include "transport_catalogue.h"
 #include "map_renderer.h"
 #include "transport_router.h"
+#include "flat_snapshot.h"
 
 #include <filesystem>
+#include <memory>
 
 namespace serialize {
 
+//формат записываемого снапшота; при чтении формат определяется по заголовку файла
+enum class SnapshotFormat {
+    PROTOBUF,   //сообщение AllData: переносимый формат для обмена
+    FLAT,       //плоский снапшот (flat_snapshot.h): process_requests читает его на месте, без разбора
+};
+
+//загружаемые части снапшота; справочник нужен остальным частям и загружается всегда
+struct SnapshotSections {
+    bool render_settings = true;
+    bool router = true;
+};
+
 class Serializator {
 public:
     Serializator (transport_catalogue::TransportCatalogue& catalog,
@@ -15,11 +29,18 @@ public:
         :catalog_(catalog), renderer_(renderer), transport_router_(transport_router) {}
 
     void SetPathToSerialize(const std::filesystem::path& path) {path_to_serialize_= path;}
+    void SetFormat(SnapshotFormat format) {format_ = format;}
     size_t Serialize(bool with_graph = false) const;
-    bool Deserialize(bool with_graph = false);
+    bool Deserialize(bool with_graph = false, SnapshotSections sections = {});
 
 private:
+    size_t SerializeFlat(bool with_graph) const;
+    bool DeserializeFlat(SnapshotSections sections);
+
     std::filesystem::path path_to_serialize_;
+    SnapshotFormat format_ = SnapshotFormat::PROTOBUF;
+    //отображённый в память плоский снапшот: на него ссылается таблица маршрутов
+    std::unique_ptr<flat::MappedSnapshot> snapshot_;
 
     transport_catalogue::TransportCatalogue& catalog_;
     renderer::MapRenderer& renderer_;
@@ -38,7 +38,7 @@ void TransportCatalogue::AddStop(std::string_view stop_name, geo::Coordinates co
     stops_to_stop_[stops_.back().name] = &(stops_.back());
 }
 void TransportCatalogue::AddBus(std::string_view route_name,
-                                std::vector<std::string_view>& stops, const bool& ring)
+                                const std::vector<std::string_view>& stops, const bool& ring)
 {
     auto it = std::lower_bound(sorted_buses_.begin(), sorted_buses_.end(), route_name);
     if (it != sorted_buses_.end() && *it == route_name) {
@@ -47,6 +47,7 @@ void TransportCatalogue::AddBus(std::string_view route_name,
     domain::Bus bus;
     //добавление имени
     bus.name = route_name;
+    bus.id = static_cast<uint32_t>(buses_.size());
     buses_.push_back(std::move(bus));
     //add отсортированный ветор
     sorted_buses_.emplace(it, buses_.back().name);
@@ -66,12 +67,7 @@ void TransportCatalogue::AddBus(std::string_view route_name,
     buses_.back().unique_stops = static_cast<int>(tmp_unique_stops.size());
     //если линейный, то добавление обратного направления
     if (!ring) {
-        //размер * 2 -1 ( A-B-C-B-A)
-        tmp_stops.reserve(tmp_stops.size() * 2 - 1);
-        for (auto it = tmp_stops.end() - 2; it != tmp_stops.begin(); --it) {
-            tmp_stops.push_back(*it);
-        }
-        tmp_stops.push_back(tmp_stops.front());
+        AddReverseDirection(tmp_stops);
     }
     else {
         buses_.back().route_type = true;
@@ -91,6 +87,61 @@ void TransportCatalogue::AddBus(std::string_view route_name,
     }
 }
 
+void TransportCatalogue::AddReverseDirection(std::vector<const domain::Stop*>& stops)
+{
+    //размер * 2 -1 ( A-B-C-B-A)
+    stops.reserve(stops.size() * 2 - 1);
+    for (auto it = stops.end() - 2; it != stops.begin(); --it) {
+        stops.push_back(*it);
+    }
+    stops.push_back(stops.front());
+}
+
+void TransportCatalogue::RestoreBus(std::string_view route_name, std::vector<const domain::Stop*>&& stops, bool ring,
+                                    int unique_stops, int distance, double curvature)
+{
+    domain::Bus bus;
+    bus.name = route_name;
+    bus.id = static_cast<uint32_t>(buses_.size());
+    //у маршрута без остановок статистики нет (как в AddBus)
+    if (!stops.empty()) {
+        if (!ring) {
+            AddReverseDirection(stops);
+        }
+        bus.route_type = ring;
+        bus.stops = std::move(stops);
+        bus.number_stops = static_cast<int>(bus.stops.size());
+        bus.unique_stops = unique_stops;
+        bus.distance = distance;
+        bus.curvature = curvature;
+    }
+    buses_.push_back(std::move(bus));
+    sorted_buses_.insert(std::lower_bound(sorted_buses_.begin(), sorted_buses_.end(), buses_.back().name),
+                         buses_.back().name);
+    buses_to_bus_.insert({ buses_.back().name, &(buses_.back()) });
+}
+
+void TransportCatalogue::RestoreStopBuses(uint32_t stop_id, ranges::Range<const uint32_t*> bus_ids)
+{
+    std::set<std::string_view>& buses = buses_on_stops_[stops_.at(stop_id).name];
+    //номера идут по возрастанию имени: вставка в конец множества за O(1)
+    for (const uint32_t bus_id : bus_ids) {
+        buses.emplace_hint(buses.end(), buses_.at(bus_id).name);
+    }
+}
+
+void TransportCatalogue::UpdateBusStats()
+{
+    for (domain::Bus& bus : buses_) {
+        //у маршрута без остановок длина и извилистость не считаются (как в AddBus)
+        if (bus.stops.empty()) {
+            continue;
+        }
+        bus.distance = CalculateAllDistance(bus.name);
+        bus.curvature = bus.distance / CalculateCurvature(bus.name);
+    }
+}
+
 std::optional<std::set<std::string_view>> TransportCatalogue::GetBusesOnStop(std::string_view name) const
 {
     //нет остановки
@@ -173,6 +224,9 @@ transport_catalog_serialize::Catalog TransportCatalogue::Serialize() const
         transport_catalog_serialize::Bus bus_to_out;
         bus_to_out.set_name(bus.name);
         bus_to_out.set_route_type(bus.route_type);
+        bus_to_out.set_unique_stops(bus.unique_stops);
+        bus_to_out.set_distance(bus.distance);
+        bus_to_out.set_curvature(bus.curvature);
         if (!bus.stops.empty ()) {
             //если некольцевой маршрут, записывается только половина остановок
             int stops_count = bus.route_type ? bus.stops.size() : bus.stops.size()/2+1;
@@ -195,6 +249,11 @@ transport_catalog_serialize::Catalog TransportCatalogue::Serialize() const
         stop_to_out.set_name(stop.name);
         stop_to_out.set_latitude(stop.coordinate.lat);
         stop_to_out.set_longitude(stop.coordinate.lng);
+        if (const auto it = buses_on_stops_.find(stop.name); it != buses_on_stops_.end()) {
+            for (std::string_view bus_name : it->second) {
+                stop_to_out.add_buses(FindBus(bus_name)->id);
+            }
+        }
         stop_list.add_stop();
         *stop_list.mutable_stop(stop_list.stop_size()-1) = stop_to_out;
     }
@@ -218,25 +277,46 @@ transport_catalog_serialize::Catalog TransportCatalogue::Serialize() const
     *catalog.mutable_bus_list () = bus_list;
     *catalog.mutable_stop_list () = stop_list;
     *catalog.mutable_distance_list () = distance_list;
+    catalog.set_has_bus_stats(true);
     return catalog;
 }
 bool TransportCatalogue::Deserialize(transport_catalog_serialize::Catalog& catalog)
 {
     //stops
-    transport_catalog_serialize::StopList stop_list = catalog.stop_list ();
+    const transport_catalog_serialize::StopList& stop_list = catalog.stop_list ();
     for (int i = 0; i < stop_list.stop_size(); ++i) {
         const transport_catalog_serialize::Stop& stop = stop_list.stop(i);
         AddStop(stop.name(), {stop.latitude(), stop.longitude()});
     }
     std::vector<const domain::Stop*> sorted_stops = SortStops();
     //distances
-    transport_catalog_serialize::DistanceList distance_list = catalog.distance_list ();
+    const transport_catalog_serialize::DistanceList& distance_list = catalog.distance_list ();
     for (int i = 0; i < distance_list.distance_size (); ++i) {
         const transport_catalog_serialize::Distance distance = distance_list.distance (i);
         distances_[{sorted_stops[distance.index_from ()], sorted_stops[distance.index_to ()]}] = distance.distance ();
 }
 //buses
-transport_catalog_serialize::BusList bus_list = catalog.bus_list ();
+const transport_catalog_serialize::BusList& bus_list = catalog.bus_list ();
+//статистика сохранена: автобусы и списки автобусов остановок присваиваются без пересчёта
+if (catalog.has_bus_stats()) {
+    for (const transport_catalog_serialize::Bus& bus_from_input : bus_list.bus()) {
+        std::vector<const domain::Stop*> stops_in_bus;
+        stops_in_bus.reserve(bus_from_input.stop_size());
+        for (const uint32_t position : bus_from_input.stop()) {
+            stops_in_bus.push_back(sorted_stops[position]);
+        }
+        RestoreBus(bus_from_input.name(), std::move(stops_in_bus), bus_from_input.route_type(),
+                   static_cast<int>(bus_from_input.unique_stops()), static_cast<int>(bus_from_input.distance()),
+                   bus_from_input.curvature());
+    }
+    for (int i = 0; i < stop_list.stop_size(); ++i) {
+        const auto& buses = stop_list.stop(i).buses();
+        if (!buses.empty()) {
+            RestoreStopBuses(static_cast<uint32_t>(i), {buses.data(), buses.data() + buses.size()});
+        }
+    }
+    return true;
+}
 for (int i = 0; i < bus_list.bus_size(); ++i) {
     const transport_catalog_serialize::Bus& bus_from_input = bus_list.bus(i);
     std::vector<std::string_view> stops_in_bus;
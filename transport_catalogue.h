@@ -26,7 +26,7 @@ public:
     //добавление остановки в базу
     void AddStop(std::string_view stop_name, geo::Coordinates coordinate) noexcept;
     //добавление маршрута в базу
-    void AddBus(std::string_view route_name,std::vector<std::string_view>& stops, const bool& ring);
+    void AddBus(std::string_view route_name, const std::vector<std::string_view>& stops, const bool& ring);
     //получение всех автобусов на остановке
     std::optional <std::set<std::string_view>> GetBusesOnStop(std::string_view stop) const;
     //задание дистанции между остановками
@@ -35,10 +35,21 @@ public:
     int GetDistance(std::string_view stop_from, std::string_view stop_to) const;
     int GetDistance(const domain::Stop* lhs, const domain::Stop* rhs) const;
     double CalculateCurvature(std::string_view name) const;
+    //пересчёт длины и извилистости маршрутов после изменения расстояний
+    void UpdateBusStats();
+    //восстановление автобуса из снапшота без пересчёта: stops — как во входных данных (у некольцевого —
+    //до конечной), статистика берётся из снапшота; автобусы восстанавливаются в порядке Bus::id
+    void RestoreBus(std::string_view route_name, std::vector<const domain::Stop*>&& stops, bool ring,
+                    int unique_stops, int distance, double curvature);
+    //восстановление списка автобусов остановки; bus_ids — номера автобусов в порядке возрастания имени
+    void RestoreStopBuses(uint32_t stop_id, ranges::Range<const uint32_t*> bus_ids);
     size_t GetVertexCount() const { return vertex_count_; }
     //получение инф о автобусе и остановке
     std::optional<const domain::Bus*> GetBusInfo(std::string_view name) const;
     std::optional<const domain::Stop*> GetStopInfo(std::string_view name) const;
+    //получение по порядковому номеру (Stop::vertex_id, Bus::id) без поиска по имени
+    const domain::Stop* GetStopById(uint32_t id) const { return &stops_[id]; }
+    const domain::Bus* GetBusById(uint32_t id) const { return &buses_[id]; }
     auto begin() const { return sorted_buses_.begin(); }
     auto end() const { return sorted_buses_.end(); }
     size_t size() const { return sorted_buses_.size(); }
@@ -58,6 +69,8 @@ private:
         }
     };
     int CalculateAllDistance(std::string_view route_name) const;
+    //дополняет некольцевой маршрут обратным направлением (A-B-C -> A-B-C-B-A)
+    static void AddReverseDirection(std::vector<const domain::Stop*>& stops);
     //поиск остановки по имени
     domain::Stop* FindStop(std::string_view stop_name) const;
     //поиск маршрута по имени
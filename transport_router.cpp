@@ -1,5 +1,9 @@
 #include "transport_router.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 namespace transport_router_ {
 
 	using namespace std::literals;
@@ -7,28 +11,98 @@ namespace transport_router_ {
 
 	std::optional<CompletedRoute> TransportRouter::ComputeRoute(graph::VertexId from, graph::VertexId to) 
 	{
-		//std::optional<typename Router<Weight>::RouteInfo>
-		std::optional<graph::Router<double>::RouteInfo> build_route_ = router_->BuildRoute(from, to);
+		std::optional<graph::RouteInfo<RouteWeight>> build_route_ = BuildRoute(from, to);
 
 		if (!build_route_) {
 			return std::nullopt;
 		}
+		std::optional<size_t> expanded_vertices;
+		if (routing_settings_.report_expanded_vertices) {
+			expanded_vertices = GetExpandedVertexCount();
+		}
 		//точность
 		if (build_route_->weight < eps) {
-			return CompletedRoute({ 0, {} });
+			return CompletedRoute({ 0, {}, expanded_vertices });
 		}
 
 		CompletedRoute result;
 		result.total_time = build_route_->weight;
+		result.expanded_vertices = expanded_vertices;
 		result.route.reserve(build_route_->edges.size());
 
 		for (auto& edge : build_route_->edges) 
 		{
-			EdgeInfo& info = edges_.at(edge);
-			double wait_time_ = static_cast<double>(routing_settings_.bus_wait_time);
-			double run_time_ = graph_.GetEdge(edge).weight - routing_settings_.bus_wait_time;
-			result.route.push_back(CompletedRoute::Line{ info.stop, info.bus, wait_time_, run_time_ ,info.count });
+			const EdgeInfo& info = edges_[edge];
+			const domain::Stop* stop = catalog_.GetStopById(info.stop);
+			const domain::Bus* bus = catalog_.GetBusById(info.bus);
+			const double weight = graph_.GetEdge(edge).weight;
+			switch (info.type) {
+			case EdgeType::BUS: {
+				double wait_time_ = static_cast<double>(routing_settings_.bus_wait_time);
+				double run_time_ = weight - routing_settings_.bus_wait_time;
+				result.route.push_back(CompletedRoute::Line{ stop, bus, wait_time_, run_time_ ,info.count });
+				break;
+			}
+			case EdgeType::WAIT:
+				result.route.push_back(CompletedRoute::Line{ stop, bus, weight, 0., 0 });
+				break;
+			case EdgeType::RIDE:
+				result.route.back().run_time += weight;
+				result.route.back().count_stops += info.count;
+				break;
+			case EdgeType::ALIGHT:
+				//посадка и выход без поездки — петля нулевого веса при bus_wait_time 0, в ответ не попадает
+				if (result.route.back().count_stops == 0) {
+					result.route.pop_back();
+				}
+				break;
+			}
+		}
+		return result;
+	}
 
+	std::vector<std::optional<double>> TransportRouter::ComputeTimes(graph::VertexId from,
+																	 const std::vector<graph::VertexId>& targets)
+	{
+		//таблица всех пар (в т.ч. ленивая — строка from считается один раз) отвечает на все цели сразу
+		if (router_) {
+			std::vector<std::optional<double>> result;
+			result.reserve(targets.size());
+			for (graph::VertexId to : targets) {
+				result.push_back(router_->GetWeight(from, to));
+			}
+			return result;
+		}
+		//по хаб-меткам — слияние меток на каждую цель, рёбра маршрута не восстанавливаются
+		if (hub_labels_) {
+			std::vector<std::optional<double>> result;
+			result.reserve(targets.size());
+			for (graph::VertexId to : targets) {
+				result.push_back(hub_labels_->GetWeight(from, to));
+			}
+			return result;
+		}
+		//иначе один поиск Дейкстры до всех целей (для иерархии — по исходному графу)
+		if (!dijkstra_router_) {
+			dijkstra_router_ = std::make_unique<graph::DijkstraRouter<RouteWeight>>(graph_);
+		}
+		const std::vector<std::optional<RouteWeight>> weights = dijkstra_router_->BuildWeights(from, targets);
+		return { weights.begin(), weights.end() };
+	}
+
+	std::vector<std::pair<const domain::Stop*, double>> TransportRouter::ComputeIsochrone(graph::VertexId from,
+																						 double time_limit)
+	{
+		if (!dijkstra_router_) {
+			dijkstra_router_ = std::make_unique<graph::DijkstraRouter<RouteWeight>>(graph_);
+		}
+		//вершины "в автобусе" модели LINES пропускаются
+		const size_t stop_count = catalog_.GetVertexCount();
+		std::vector<std::pair<const domain::Stop*, double>> result;
+		for (const auto& [vertex, time] : dijkstra_router_->BuildReachable(from, static_cast<RouteWeight>(time_limit))) {
+			if (vertex < stop_count) {
+				result.push_back({ catalog_.GetStopById(static_cast<uint32_t>(vertex)), time });
+			}
 		}
 		return result;
 	}
@@ -39,7 +113,95 @@ namespace transport_router_ {
 			throw std::logic_error("Recreate graph"s);
 		}
 
-		graph_.SetVertexCount(catalog_.GetVertexCount());
+		BuildGraph(graph_, edges_);
+        if (flag_graph){
+            CreateRouter();
+        }
+	}
+
+	void TransportRouter::UpdateGraph()
+	{
+		if (graph_.GetVertexCount() == 0) {
+			CreateGraph();
+			return;
+		}
+		graph::DirectedWeightedGraph<RouteWeight> graph;
+		std::vector<EdgeInfo> edges;
+		BuildGraph(graph, edges);
+
+		bool same_structure = graph.GetVertexCount() == graph_.GetVertexCount()
+			&& graph.GetEdgeCount() == graph_.GetEdgeCount();
+		for (graph::EdgeId edge_id = 0; same_structure && edge_id < graph.GetEdgeCount(); ++edge_id) {
+			const graph::Edge<RouteWeight> edge = graph.GetEdge(edge_id);
+			const graph::Edge<RouteWeight> old_edge = graph_.GetEdge(edge_id);
+			same_structure = edge.from == old_edge.from && edge.to == old_edge.to;
+		}
+		//добавились остановки или автобусы: граф и маршрутизатор строятся заново
+		if (!same_structure) {
+			router_.reset();
+			dijkstra_router_.reset();
+			bidirectional_router_.reset();
+			contraction_hierarchy_.reset();
+			hub_labels_.reset();
+			graph_ = std::move(graph);
+			edges_ = std::move(edges);
+			CreateRouter();
+			return;
+		}
+
+		std::vector<std::pair<graph::EdgeId, RouteWeight>> previous_weights;
+		for (graph::EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+			const RouteWeight weight = graph.GetEdge(edge_id).weight;
+			const RouteWeight old_weight = graph_.GetEdge(edge_id).weight;
+			if (weight != old_weight) {
+				previous_weights.push_back({ edge_id, old_weight });
+				graph_.SetEdgeWeight(edge_id, weight);
+			}
+		}
+		switch (routing_settings_.router_type) {
+		case RouterType::ALL_PAIRS:
+		case RouterType::LAZY_ALL_PAIRS:
+			router_->UpdateEdges(previous_weights);
+			break;
+		case RouterType::A_STAR:
+			InitHeuristic();	//нижняя граница времени на метр зависит от расстояний
+			break;
+		case RouterType::CONTRACTION_HIERARCHIES:
+		case RouterType::HUB_LABELS:
+			//предобработка зависит от всех весов
+			if (!previous_weights.empty()) {
+				CreateRouter();
+			}
+			break;
+		case RouterType::DIJKSTRA:
+		case RouterType::BIDIRECTIONAL_DIJKSTRA:
+			break;
+		}
+	}
+
+	void TransportRouter::BuildGraph(graph::DirectedWeightedGraph<RouteWeight>& graph, std::vector<EdgeInfo>& edges) const
+	{
+		std::vector<EdgeInfo> added_edges;
+		switch (routing_settings_.graph_model) {
+		case GraphModel::COMPLETE:
+			CreateCompleteGraph(graph, added_edges);
+			break;
+		case GraphModel::LINES:
+			CreateLineGraph(graph, added_edges);
+			break;
+		}
+		//рёбра переупорядочены по исходной вершине: переносим описания на новые id
+		const std::vector<graph::EdgeId> new_ids = graph.Freeze();
+		edges.assign(added_edges.size(), {});
+		for (graph::EdgeId edge_id = 0; edge_id < added_edges.size(); ++edge_id) {
+			edges[new_ids[edge_id]] = added_edges[edge_id];
+		}
+	}
+
+	void TransportRouter::CreateCompleteGraph(graph::DirectedWeightedGraph<RouteWeight>& graph,
+											  std::vector<EdgeInfo>& edges) const
+	{
+		graph.SetVertexCount(catalog_.GetVertexCount());
 		double bus_velocity = routing_settings_.bus_velocity * kmh_to_mmin;
 
 		for (std::string_view bus_name : catalog_)
@@ -54,14 +216,161 @@ namespace transport_router_ {
 
 				for (auto next_vertex = it + 1; next_vertex != bus->stops.end(); ++next_vertex) {
 					time += catalog_.GetDistance(*prev(next_vertex), *next_vertex) / bus_velocity;
-					edges_[graph_.AddEdge({ (*it)->vertex_id,(*next_vertex)->vertex_id, time })]
-						= { *it,bus,static_cast<uint32_t>(next_vertex - it) };
+					graph.AddEdge({ (*it)->vertex_id,(*next_vertex)->vertex_id, static_cast<RouteWeight>(time) });
+					edges.push_back({ static_cast<uint32_t>((*it)->vertex_id), bus->id, static_cast<uint32_t>(next_vertex - it) });
 				}
 			}
 		}
-        if (flag_graph){
-            router_ = std::make_unique<graph::Router<double>>(graph_);
-        }
+	}
+
+	//вершины 0..stops-1 — остановки, далее для каждого автобуса по вершине на каждую позицию маршрута.
+	//Остановка -> позиция: ожидание, позиция -> следующая позиция: перегон, позиция -> остановка: выход (0)
+	void TransportRouter::CreateLineGraph(graph::DirectedWeightedGraph<RouteWeight>& graph,
+										  std::vector<EdgeInfo>& edges) const
+	{
+		size_t vertex_count = catalog_.GetVertexCount();
+		for (std::string_view bus_name : catalog_) {
+			vertex_count += (*catalog_.GetBusInfo(bus_name))->stops.size();
+		}
+		graph.SetVertexCount(vertex_count);
+		double bus_velocity = routing_settings_.bus_velocity * kmh_to_mmin;
+
+		graph::VertexId ride_vertex = catalog_.GetVertexCount();
+		for (std::string_view bus_name : catalog_)
+		{
+			const domain::Bus* bus = *(catalog_.GetBusInfo(bus_name));
+			const std::vector<const domain::Stop*>& stops = bus->stops;
+			for (size_t i = 0; stops.size() > 1 && i < stops.size(); ++i) {
+				if (i + 1 < stops.size()) {
+					graph.AddEdge({ stops[i]->vertex_id, ride_vertex + i,
+									 static_cast<RouteWeight>(routing_settings_.bus_wait_time) });
+					edges.push_back({ static_cast<uint32_t>(stops[i]->vertex_id), bus->id, 0, EdgeType::WAIT });
+					graph.AddEdge({ ride_vertex + i, ride_vertex + i + 1,
+									 static_cast<RouteWeight>(catalog_.GetDistance(stops[i], stops[i + 1]) / bus_velocity) });
+					edges.push_back({ static_cast<uint32_t>(stops[i]->vertex_id), bus->id, 1, EdgeType::RIDE });
+				}
+				if (i > 0) {
+					graph.AddEdge({ ride_vertex + i, stops[i]->vertex_id, RouteWeight{} });
+					edges.push_back({ static_cast<uint32_t>(stops[i]->vertex_id), bus->id, 0, EdgeType::ALIGHT });
+				}
+			}
+			ride_vertex += stops.size();
+		}
+	}
+
+	std::optional<graph::RouteInfo<RouteWeight>> TransportRouter::BuildRoute(graph::VertexId from, graph::VertexId to) const
+	{
+		switch (routing_settings_.router_type) {
+		case RouterType::ALL_PAIRS:
+		case RouterType::LAZY_ALL_PAIRS:
+			return router_->BuildRoute(from, to);
+		case RouterType::DIJKSTRA:
+			return dijkstra_router_->BuildRoute(from, to);
+		case RouterType::CONTRACTION_HIERARCHIES:
+			return contraction_hierarchy_->BuildRoute(from, to);
+		case RouterType::BIDIRECTIONAL_DIJKSTRA:
+			return bidirectional_router_->BuildRoute(from, to);
+		case RouterType::HUB_LABELS:
+			return hub_labels_->BuildRoute(from, to);
+		case RouterType::A_STAR: {
+			//с остановки до любой другой нужна хотя бы одна посадка с ожиданием
+			//(из вершины "в автобусе" — не обязательно)
+			const geo::Coordinates target = vertex_coordinates_[to];
+			const size_t stop_count = catalog_.GetVertexCount();
+			return dijkstra_router_->BuildRoute(from, to, [this, to, target, stop_count](graph::VertexId vertex) {
+				const double wait_time = vertex != to && vertex < stop_count ? routing_settings_.bus_wait_time : 0.;
+				const double estimate = wait_time + geo::ComputeDistance(vertex_coordinates_[vertex], target) * min_time_per_meter_;
+				//округление до float может дать значение больше оценки — тогда берётся соседнее снизу,
+				//иначе оценка перестала бы быть нижней границей
+				RouteWeight bound = static_cast<RouteWeight>(estimate);
+				if (bound > estimate) {
+					bound = std::nextafter(bound, RouteWeight{0});
+				}
+				return bound;
+			});
+		}
+		}
+		throw std::logic_error("Unknown router type"s);
+	}
+
+	size_t TransportRouter::GetExpandedVertexCount() const
+	{
+		switch (routing_settings_.router_type) {
+		case RouterType::DIJKSTRA:
+		case RouterType::A_STAR:
+			return dijkstra_router_->GetExpandedVertexCount();
+		case RouterType::CONTRACTION_HIERARCHIES:
+			return contraction_hierarchy_->GetExpandedVertexCount();
+		case RouterType::BIDIRECTIONAL_DIJKSTRA:
+			return bidirectional_router_->GetExpandedVertexCount();
+		default:
+			return 0;	//таблица всех пар: поиска нет
+		}
+	}
+
+	void TransportRouter::InitHeuristic()
+	{
+		vertex_coordinates_.assign(graph_.GetVertexCount(), {0, 0});
+		for (std::string_view stop_name : catalog_.GetSortedStopsNames()) {
+			const domain::Stop* stop = *catalog_.GetStopInfo(stop_name);
+			vertex_coordinates_[stop->vertex_id] = stop->coordinate;
+		}
+		//вершины позиций маршрута (модель LINES) — в точке своей остановки
+		for (graph::EdgeId edge_id = 0; edge_id < edges_.size(); ++edge_id) {
+			const EdgeInfo& info = edges_[edge_id];
+			const graph::Edge<RouteWeight> edge = graph_.GetEdge(edge_id);
+			if (info.type == EdgeType::WAIT) {
+				vertex_coordinates_[edge.to] = catalog_.GetStopById(info.stop)->coordinate;
+			} else if (info.type == EdgeType::ALIGHT) {
+				vertex_coordinates_[edge.from] = catalog_.GetStopById(info.stop)->coordinate;
+			}
+		}
+		//время на ребре не меньше (ожидание +) дорожное расстояние / скорость, а дорожное расстояние
+		//перегона оценивается снизу расстоянием по прямой с наименьшим коэффициентом по всем перегонам;
+		//тогда оценка по прямой до цели допустима и согласована (неравенство треугольника)
+		double min_ratio = 1.;
+		for (std::string_view bus_name : catalog_) {
+			const domain::Bus* bus = *catalog_.GetBusInfo(bus_name);
+			for (size_t i = 1; i < bus->stops.size(); ++i) {
+				const double direct = geo::ComputeDistance(bus->stops[i - 1]->coordinate, bus->stops[i]->coordinate);
+				if (direct > 0) {
+					min_ratio = std::min(min_ratio, catalog_.GetDistance(bus->stops[i - 1], bus->stops[i]) / direct);
+				}
+			}
+		}
+		//запас на погрешность acos в ComputeDistance, а при весах float — и на округление весов рёбер
+		//и их сумм: вес пути в float может оказаться чуть меньше точного
+		constexpr double margin = std::max(1e-9, 64. * std::numeric_limits<RouteWeight>::epsilon());
+		min_time_per_meter_ = min_ratio * (1. - margin) / (routing_settings_.bus_velocity * kmh_to_mmin);
+	}
+
+	void TransportRouter::CreateRouter()
+	{
+		switch (routing_settings_.router_type) {
+		case RouterType::ALL_PAIRS:
+			router_ = std::make_unique<graph::Router<RouteWeight>>(graph_);
+			break;
+		case RouterType::DIJKSTRA:
+			dijkstra_router_ = std::make_unique<graph::DijkstraRouter<RouteWeight>>(graph_);
+			break;
+		case RouterType::CONTRACTION_HIERARCHIES:
+			contraction_hierarchy_ = std::make_unique<graph::ContractionHierarchy<RouteWeight>>(graph_);
+			break;
+		case RouterType::A_STAR:
+			InitHeuristic();
+			dijkstra_router_ = std::make_unique<graph::DijkstraRouter<RouteWeight>>(graph_);
+			break;
+		case RouterType::BIDIRECTIONAL_DIJKSTRA:
+			bidirectional_router_ = std::make_unique<graph::BidirectionalDijkstraRouter<RouteWeight>>(graph_);
+			break;
+		case RouterType::HUB_LABELS:
+			hub_labels_ = std::make_unique<graph::HubLabels<RouteWeight>>(graph_);
+			break;
+		case RouterType::LAZY_ALL_PAIRS:
+			router_ = std::make_unique<graph::Router<RouteWeight>>(
+				graph_, graph::Router<RouteWeight>::LazyRows{size_t(routing_settings_.route_cache_mb) << 20});
+			break;
+		}
 	}
 
 	void TransportRouter::SetSettings(RoutingSettings && settings)
@@ -74,51 +383,117 @@ namespace transport_router_ {
         transport_catalog_serialize::RoutingSettings settings;
         settings.set_bus_wait_time(routing_settings_.bus_wait_time);
         settings.set_bus_velocity(routing_settings_.bus_velocity);
+        settings.set_router_type(static_cast<transport_catalog_serialize::RouterType>(routing_settings_.router_type));
+        settings.set_report_expanded_vertices(routing_settings_.report_expanded_vertices);
+        settings.set_graph_model(static_cast<transport_catalog_serialize::GraphModel>(routing_settings_.graph_model));
+        settings.set_route_cache_mb(routing_settings_.route_cache_mb);
         *data_out.mutable_settings() = settings;
-        *data_out.mutable_data() = router_->GetSerializeData();
+        if (contraction_hierarchy_) {
+            *data_out.mutable_contraction_hierarchy() = contraction_hierarchy_->GetSerializeData();
+        }
+        if (hub_labels_) {
+            *data_out.mutable_hub_labels() = hub_labels_->GetSerializeData();
+        }
         if (with_graph) {
             *data_out.mutable_graph() = graph_.GetSerializeData();
-            std::vector<std::string_view> buses(catalog_.begin(), catalog_.end());
-            std::vector<std::string_view> stops = catalog_.GetSortedStopsNames();
-            for (const auto& [edge_id, edge_info] : edges_) {
-                transport_catalog_serialize::EdgeInfo info_to_out;
-                auto it_stop = std::lower_bound(stops.begin(), stops.end(),
-                                                edge_info.stop->name, std::less<>{});
-                info_to_out.set_stop(static_cast<uint32_t>(it_stop - stops.begin()));
-                auto it_bus = std::lower_bound(buses.begin(), buses.end(),
-                                               edge_info.bus->name, std::less<>{});
-                info_to_out.set_bus(static_cast<uint32_t>(it_bus - buses.begin()));
-                info_to_out.set_count(edge_info.count);
-                (*data_out.mutable_graph()->mutable_info())[edge_id] = info_to_out;
+            //описания рёбер — параллельные массивы по id ребра; порядок остановок и автобусов
+            //в справочнике при сериализации сохраняется, поэтому их номера пишутся как есть
+            transport_catalog_serialize::EdgeInfoList& info_out = *data_out.mutable_graph()->mutable_info();
+            info_out.mutable_stop()->Reserve(static_cast<int>(edges_.size()));
+            info_out.mutable_bus()->Reserve(static_cast<int>(edges_.size()));
+            info_out.mutable_count()->Reserve(static_cast<int>(edges_.size()));
+            info_out.mutable_type()->Reserve(static_cast<int>(edges_.size()));
+            for (const EdgeInfo& edge_info : edges_) {
+                info_out.add_stop(edge_info.stop);
+                info_out.add_bus(edge_info.bus);
+                info_out.add_count(edge_info.count);
+                info_out.add_type(static_cast<transport_catalog_serialize::EdgeType>(edge_info.type));
             }
         }
         return data_out;
     }
 
+    std::optional<graph::Router<RouteWeight>::TableView> TransportRouter::GetRouteTable() const {
+        //таблица маршрутов нужна только для ALL_PAIRS, остальные режимы считают путь по графу
+        if (routing_settings_.router_type == RouterType::ALL_PAIRS && router_) {
+            return router_->GetTable();
+        }
+        return std::nullopt;
+    }
+
     bool TransportRouter::Deserialize(transport_catalog_serialize::Router &router_data, bool with_graph) {
         routing_settings_ = {router_data.settings().bus_wait_time(),
-                             router_data.settings().bus_velocity()};
+                             router_data.settings().bus_velocity(),
+                             static_cast<RouterType>(router_data.settings().router_type()),
+                             router_data.settings().report_expanded_vertices(),
+                             static_cast<GraphModel>(router_data.settings().graph_model()),
+                             router_data.settings().route_cache_mb()};
         const transport_catalog_serialize::Graph& graph = router_data.graph();
         if (with_graph) {
-            std::vector<std::string_view> buses(catalog_.begin(), catalog_.end());
-            std::vector<std::string_view> stops = catalog_.GetSortedStopsNames();
-            graph_.SetVertexCount(stops.size());
-            for (int i = 0; i < graph.edges_size(); ++i) {
-                uint32_t edge_id = graph_.AddEdge ({ graph.edges(i).from(),
-                                                     graph.edges(i).to(),
-                                                     graph.edges(i).weight()});
-                const transport_catalog_serialize::EdgeInfo& edge_info = (graph.info().at(edge_id));
-                edges_[edge_id] = EdgeInfo{*catalog_.GetStopInfo(stops[edge_info.stop()]),
-                                           *catalog_.GetBusInfo(buses[edge_info.bus()]),
-                                           edge_info.count()};
+            graph_.SetSerializeData(graph);
+            const transport_catalog_serialize::EdgeInfoList& info = graph.info();
+            const size_t edge_count = graph_.GetEdgeCount();
+            if (static_cast<size_t>(info.stop_size()) != edge_count || static_cast<size_t>(info.bus_size()) != edge_count
+                    || static_cast<size_t>(info.count_size()) != edge_count || static_cast<size_t>(info.type_size()) != edge_count) {
+                throw std::invalid_argument("Edge info size mismatch"s);
+            }
+            edges_.resize(edge_count);
+            for (graph::EdgeId edge_id = 0; edge_id < edge_count; ++edge_id) {
+                edges_[edge_id] = EdgeInfo{info.stop(edge_id), info.bus(edge_id), info.count(edge_id),
+                                           static_cast<EdgeType>(info.type(edge_id))};
             }
+            CheckEdgeInfo();
         } else {
             CreateGraph(false);
         }
-        router_ = std::make_unique<graph::Router<double>>(graph_, router_data.data());
+        if (routing_settings_.router_type == RouterType::ALL_PAIRS) {
+            router_ = std::make_unique<graph::Router<RouteWeight>>(graph_, router_data.data());
+        } else if (routing_settings_.router_type == RouterType::CONTRACTION_HIERARCHIES) {
+            contraction_hierarchy_ = std::make_unique<graph::ContractionHierarchy<RouteWeight>>(
+                        graph_, router_data.contraction_hierarchy());
+        } else if (routing_settings_.router_type == RouterType::HUB_LABELS) {
+            hub_labels_ = std::make_unique<graph::HubLabels<RouteWeight>>(graph_, router_data.hub_labels());
+        } else {
+            CreateRouter();
+        }
         return true;
     }
 
+    void TransportRouter::CheckEdgeInfo() const {
+        const size_t stop_count = catalog_.GetVertexCount();
+        const size_t bus_count = catalog_.size();
+        for (const EdgeInfo& edge_info : edges_) {
+            if (edge_info.stop >= stop_count || edge_info.bus >= bus_count || edge_info.type > EdgeType::ALIGHT) {
+                throw std::invalid_argument("Edge info is out of range"s);
+            }
+        }
+    }
 
+    bool TransportRouter::DeserializeFlat(FlatRouterData&& router_data) {
+        routing_settings_ = router_data.settings;
+        if (router_data.has_graph) {
+            graph_.SetFlatData(router_data.vertex_count, router_data.graph_offsets, router_data.graph_targets,
+                               router_data.graph_weights);
+            if (router_data.edges.size() != graph_.GetEdgeCount()) {
+                throw std::invalid_argument("Edge info size mismatch"s);
+            }
+            edges_ = std::move(router_data.edges);
+            CheckEdgeInfo();
+        } else {
+            CreateGraph(false);
+        }
+        if (routing_settings_.router_type == RouterType::ALL_PAIRS) {
+            router_ = std::make_unique<graph::Router<RouteWeight>>(graph_, router_data.route_table);
+        } else if (routing_settings_.router_type == RouterType::CONTRACTION_HIERARCHIES
+                   && router_data.contraction_hierarchy) {
+            contraction_hierarchy_ = std::make_unique<graph::ContractionHierarchy<RouteWeight>>(
+                        graph_, *router_data.contraction_hierarchy);
+        } else if (routing_settings_.router_type == RouterType::HUB_LABELS && router_data.hub_labels) {
+            hub_labels_ = std::make_unique<graph::HubLabels<RouteWeight>>(graph_, *router_data.hub_labels);
+        } else {
+            CreateRouter();
+        }
+        return true;
+    }
 
 }//namespace routing_settings
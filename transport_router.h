@@ -2,6 +2,10 @@
 
 #include "transport_catalogue.h"
 #include "router.h"
+#include "dijkstra_router.h"
+#include "bidirectional_dijkstra_router.h"
+#include "contraction_hierarchy.h"
+#include "hub_labels.h"
 
 #include <memory>
 #include <set>
@@ -14,17 +18,56 @@ const double kmh_to_mmin = 1000 * 1.0 / 60;
 
 namespace transport_router_ {
 
+	//тип весов графа и таблицы маршрутов: float вдвое сокращает память таблицы и снапшот,
+	//total_time при этом вычисляется с относительной погрешностью порядка 1e-6
+#ifdef TRANSPORT_ROUTER_FLOAT_WEIGHTS
+	using RouteWeight = float;
+#else
+	using RouteWeight = double;
+#endif
+
+	//способ поиска маршрута
+	enum class RouterType {
+		ALL_PAIRS,	//таблица всех пар на этапе make_base
+		DIJKSTRA,	//поиск на каждый запрос, таблица не хранится
+		CONTRACTION_HIERARCHIES,	//иерархия шорткатов строится на make_base, запрос — поиск вверх по ней
+		A_STAR,		//поиск на каждый запрос с оценкой остатка пути по координатам остановок
+		LAZY_ALL_PAIRS,	//строки таблицы всех пар считаются при первом запросе из остановки и кэшируются
+		BIDIRECTIONAL_DIJKSTRA,	//встречный поиск от обеих остановок на каждый запрос
+		HUB_LABELS,	//хаб-метки строятся на make_base, время в пути — слиянием двух меток
+	};
+
+	//модель графа маршрутов
+	enum class GraphModel {
+		COMPLETE,	//ребро от каждой остановки до каждой следующей на маршруте: O(n²) рёбер на автобус
+		LINES,		//вершины "в автобусе" для каждой позиции маршрута: посадка, перегон, выход — O(n) рёбер
+	};
+
 	struct RoutingSettings 
 	{
 		uint32_t bus_wait_time = 0;
 		uint32_t bus_velocity = 0;
+		RouterType router_type = RouterType::ALL_PAIRS;
+		bool report_expanded_vertices = false;	//выводить в ответе Route число просмотренных вершин
+		GraphModel graph_model = GraphModel::COMPLETE;
+		uint32_t route_cache_mb = 0;	//LAZY_ALL_PAIRS: память на кэш строк, 0 — без ограничения
 	};
 
+	//вид ребра графа
+	enum class EdgeType : uint8_t {
+		BUS,	//COMPLETE: ожидание и поездка на count перегонов
+		WAIT,	//LINES: посадка на остановке stop (ожидание)
+		RIDE,	//LINES: один перегон от остановки stop
+		ALIGHT,	//LINES: выход на остановке stop
+	};
+
+	//описание ребра графа; хранится в плотном массиве по id ребра
 	struct EdgeInfo
 	{
-		const domain::Stop* stop;
-		const domain::Bus* bus;
+		uint32_t stop;	//Stop::vertex_id
+		uint32_t bus;	//Bus::id
 		uint32_t count;
+		EdgeType type = EdgeType::BUS;
 	};
 
 	struct CompletedRoute {
@@ -37,6 +80,22 @@ namespace transport_router_ {
 		};
 		double total_time;
 		std::vector<Line> route;
+		std::optional<size_t> expanded_vertices;
+	};
+
+	//данные маршрутизатора из плоского снапшота: массивы указывают в отображённый в память файл
+	struct FlatRouterData {
+		RoutingSettings settings;
+		bool has_graph = false;	//иначе граф строится по справочнику
+		size_t vertex_count = 0;
+		ranges::Range<const uint32_t*> graph_offsets{nullptr, nullptr};
+		ranges::Range<const uint32_t*> graph_targets{nullptr, nullptr};
+		ranges::Range<const RouteWeight*> graph_weights{nullptr, nullptr};
+		std::vector<EdgeInfo> edges;
+		//таблица маршрутов ALL_PAIRS используется на месте
+		graph::Router<RouteWeight>::TableView route_table;
+		const transport_catalog_serialize::ContractionHierarchy* contraction_hierarchy = nullptr;
+		const transport_catalog_serialize::HubLabels* hub_labels = nullptr;
 	};
 
 	class TransportRouter {
@@ -45,19 +104,50 @@ namespace transport_router_ {
 		explicit TransportRouter(transport_catalogue::TransportCatalogue& catalog) : catalog_(catalog) {}
 
 		std::optional<CompletedRoute> ComputeRoute(graph::VertexId from, graph::VertexId to);
+		//время в пути из from до каждой из targets (nullopt — недостижима), один поиск на источник
+		std::vector<std::optional<double>> ComputeTimes(graph::VertexId from, const std::vector<graph::VertexId>& targets);
+		//остановки, достижимые из from не дольше чем за time_limit, по возрастанию времени; сама from в ответ
+		//не входит. Один ограниченный поиск
+		std::vector<std::pair<const domain::Stop*, double>> ComputeIsochrone(graph::VertexId from, double time_limit);
         void CreateGraph(bool flag_graph = true);
+		//перестраивает граф по изменившемуся справочнику (расстояния, новые остановки и автобусы).
+		//Если изменились только веса рёбер, таблица маршрутов чинится по затронутым строкам,
+		//иначе граф и маршрутизатор строятся заново
+		void UpdateGraph();
 		void SetSettings(RoutingSettings&& settings);
 
+        //данные маршрутизатора без таблицы маршрутов: она велика и пишется из массивов GetRouteTable
         transport_catalog_serialize::Router Serialize (bool with_graph = false) const;
+        //таблица маршрутов ALL_PAIRS, если она хранится в снапшоте
+        std::optional<graph::Router<RouteWeight>::TableView> GetRouteTable() const;
         bool Deserialize(transport_catalog_serialize::Router& router_data, bool with_graph = false);
+        bool DeserializeFlat(FlatRouterData&& router_data);
 
 	private:
+		std::optional<graph::RouteInfo<RouteWeight>> BuildRoute(graph::VertexId from, graph::VertexId to) const;
+		size_t GetExpandedVertexCount() const;
+		//строит граф выбранной модели по справочнику и замораживает его; edges — описания рёбер по их id
+		void BuildGraph(graph::DirectedWeightedGraph<RouteWeight>& graph, std::vector<EdgeInfo>& edges) const;
+		void CreateCompleteGraph(graph::DirectedWeightedGraph<RouteWeight>& graph, std::vector<EdgeInfo>& edges) const;
+		void CreateLineGraph(graph::DirectedWeightedGraph<RouteWeight>& graph, std::vector<EdgeInfo>& edges) const;
+		void CreateRouter();
+		//описания рёбер из снапшота ссылаются на существующие остановки и автобусы справочника
+		void CheckEdgeInfo() const;
+		//данные эвристики A*: координаты вершин и нижняя граница времени на метр по прямой
+		void InitHeuristic();
+
 		transport_catalogue::TransportCatalogue& catalog_;
 
 		RoutingSettings routing_settings_;
-		graph::DirectedWeightedGraph<double> graph_;
-		std::unordered_map<graph::EdgeId, EdgeInfo> edges_;
-		std::unique_ptr<graph::Router<double>> router_;
+		graph::DirectedWeightedGraph<RouteWeight> graph_;
+		std::vector<EdgeInfo> edges_;
+		std::unique_ptr<graph::Router<RouteWeight>> router_;
+		std::unique_ptr<graph::DijkstraRouter<RouteWeight>> dijkstra_router_;
+		std::unique_ptr<graph::BidirectionalDijkstraRouter<RouteWeight>> bidirectional_router_;
+		std::unique_ptr<graph::ContractionHierarchy<RouteWeight>> contraction_hierarchy_;
+		std::unique_ptr<graph::HubLabels<RouteWeight>> hub_labels_;
+		std::vector<geo::Coordinates> vertex_coordinates_;
+		double min_time_per_meter_ = 0.;
 	};
 
 }//namespace transport_router
@@ -0,0 +1,357 @@
+//Сравнительный тест маршрутизаторов: на небольшой случайной сети make_base и process_requests
+//выполняются для каждого сочетания router_type × graph_model × формат снапшота × bus_wait_time
+//(в том числе 0: рёбра нулевого веса), ответы Route, RouteMatrix и Isochrone сверяются
+//с независимым Флойдом–Уоршеллом по остановкам, а items маршрута — с сетью.
+#include "request_handler.h"
+
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+using namespace std::literals;
+
+namespace {
+
+constexpr double INF = std::numeric_limits<double>::infinity();
+//веса float дают около 7 значащих цифр, погрешность накапливается по рёбрам маршрута
+constexpr double TOLERANCE = std::is_same_v<transport_router_::RouteWeight, float> ? 1e-4 : 1e-9;
+constexpr double ISOCHRONE_LIMIT = 25.;
+constexpr int BUS_VELOCITY = 36;
+
+const std::vector<std::string> ROUTER_TYPES = {"all_pairs", "lazy_all_pairs", "dijkstra", "a_star",
+                                               "bidirectional_dijkstra", "contraction_hierarchies", "hub_labels"};
+const std::vector<std::string> GRAPH_MODELS = {"complete", "lines"};
+const std::vector<std::string> FORMATS = {"protobuf", "flat"};
+const std::vector<int> WAIT_TIMES = {0, 6};
+
+struct Network {
+    std::vector<std::string> stops;
+    std::vector<std::pair<double, double>> coordinates;
+    //маршрут автобуса как во входных данных и полный путь (некольцевой — туда и обратно)
+    std::vector<std::vector<size_t>> bus_stops;
+    std::vector<bool> is_roundtrip;
+    std::vector<std::vector<size_t>> bus_paths;
+    std::map<std::pair<size_t, size_t>, int> distances;
+
+    //как TransportCatalogue::GetDistance: расстояние в обратную сторону, если прямое не задано
+    int GetDistance(size_t from, size_t to) const {
+        const auto it = distances.find({from, to});
+        return it != distances.end() ? it->second : distances.at({to, from});
+    }
+};
+
+bool IsClose(double lhs, double rhs) {
+    return std::abs(lhs - rhs) <= TOLERANCE * std::max(1., std::max(std::abs(lhs), std::abs(rhs)));
+}
+
+void Check(bool condition, const std::string& message) {
+    if (!condition) {
+        throw std::runtime_error(message);
+    }
+}
+
+//последние две остановки ни одним автобусом не обслуживаются: маршрутов до них нет
+Network GenerateNetwork() {
+    constexpr size_t STOP_COUNT = 26;
+    constexpr size_t SERVED_STOP_COUNT = STOP_COUNT - 2;
+    constexpr size_t BUS_COUNT = 9;
+    std::mt19937 generator(20240517);
+    auto random = [&generator](size_t from, size_t to) {
+        return from + generator() % (to - from + 1);
+    };
+
+    Network network;
+    for (size_t i = 0; i < STOP_COUNT; ++i) {
+        network.stops.push_back("Stop "s + std::to_string(i));
+        network.coordinates.push_back({55.6 + random(0, 10000) * 2e-5, 37.4 + random(0, 10000) * 3e-5});
+    }
+    for (size_t bus = 0; bus < BUS_COUNT; ++bus) {
+        std::vector<size_t> candidates(SERVED_STOP_COUNT);
+        for (size_t i = 0; i < SERVED_STOP_COUNT; ++i) {
+            candidates[i] = i;
+        }
+        std::vector<size_t> stops;
+        for (size_t count = random(2, 7); stops.size() < count;) {
+            const size_t index = random(0, candidates.size() - 1);
+            stops.push_back(candidates[index]);
+            candidates.erase(candidates.begin() + index);
+        }
+        const bool is_roundtrip = bus % 3 == 0;
+        std::vector<size_t> path = stops;
+        if (is_roundtrip) {
+            stops.push_back(stops.front());
+            path = stops;
+        } else {
+            path.insert(path.end(), stops.rbegin() + 1, stops.rend());
+        }
+        for (size_t i = 1; i < stops.size(); ++i) {
+            network.distances.emplace(std::pair{stops[i - 1], stops[i]}, static_cast<int>(random(300, 4000)));
+        }
+        //часть перегонов в обратную сторону длиннее прямых
+        if (!is_roundtrip && bus % 2 == 0) {
+            network.distances.emplace(std::pair{stops[1], stops[0]}, static_cast<int>(random(4000, 6000)));
+        }
+        network.bus_stops.push_back(std::move(stops));
+        network.is_roundtrip.push_back(is_roundtrip);
+        network.bus_paths.push_back(std::move(path));
+    }
+    return network;
+}
+
+//время между остановками по модели COMPLETE: ожидание + поездка на одном автобусе через любое число перегонов
+std::vector<std::vector<double>> ComputeExpectedTimes(const Network& network, int wait_time) {
+    const size_t n = network.stops.size();
+    const double velocity = BUS_VELOCITY * 1000. / 60.;
+    std::vector<std::vector<double>> times(n, std::vector<double>(n, INF));
+    for (size_t i = 0; i < n; ++i) {
+        times[i][i] = 0.;
+    }
+    for (const std::vector<size_t>& path : network.bus_paths) {
+        for (size_t from = 0; from < path.size(); ++from) {
+            double time = wait_time;
+            for (size_t to = from + 1; to < path.size(); ++to) {
+                time += network.GetDistance(path[to - 1], path[to]) / velocity;
+                times[path[from]][path[to]] = std::min(times[path[from]][path[to]], time);
+            }
+        }
+    }
+    for (size_t k = 0; k < n; ++k) {
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = 0; j < n; ++j) {
+                times[i][j] = std::min(times[i][j], times[i][k] + times[k][j]);
+            }
+        }
+    }
+    return times;
+}
+
+std::string MakeBaseInput(const Network& network, const std::string& file, const std::string& format,
+                          const std::string& router_type, const std::string& graph_model, int wait_time) {
+    std::ostringstream out;
+    out.precision(17);
+    out << R"({"serialization_settings": {"file": ")" << file << R"(", "format": ")" << format << R"("},)"
+        << R"("routing_settings": {"bus_wait_time": )" << wait_time << R"(, "bus_velocity": )" << BUS_VELOCITY
+        << R"(, "router_type": ")" << router_type << R"(", "graph_model": ")" << graph_model << R"("},)"
+        << R"("render_settings": {"width": 600, "height": 400, "padding": 50, "stop_radius": 5, "line_width": 14,)"
+        << R"("bus_label_font_size": 20, "bus_label_offset": [7, 15], "stop_label_font_size": 18,)"
+        << R"("stop_label_offset": [7, -3], "underlayer_color": "white", "underlayer_width": 3,)"
+        << R"("color_palette": ["green", "red"]}, "base_requests": [)";
+    for (size_t stop = 0; stop < network.stops.size(); ++stop) {
+        out << R"({"type": "Stop", "name": ")" << network.stops[stop] << R"(", "latitude": )"
+            << network.coordinates[stop].first << R"(, "longitude": )" << network.coordinates[stop].second
+            << R"(, "road_distances": {)";
+        bool first = true;
+        for (const auto& [stops, distance] : network.distances) {
+            if (stops.first == stop) {
+                out << (first ? ""sv : ", "sv) << '"' << network.stops[stops.second] << R"(": )" << distance;
+                first = false;
+            }
+        }
+        out << "}},";
+    }
+    for (size_t bus = 0; bus < network.bus_stops.size(); ++bus) {
+        out << (bus > 0 ? ", "sv : ""sv) << R"({"type": "Bus", "name": "Bus )" << bus << R"(", "stops": [)";
+        for (size_t i = 0; i < network.bus_stops[bus].size(); ++i) {
+            out << (i > 0 ? ", "sv : ""sv) << '"' << network.stops[network.bus_stops[bus][i]] << '"';
+        }
+        out << R"(], "is_roundtrip": )" << (network.is_roundtrip[bus] ? "true"sv : "false"sv) << '}';
+    }
+    out << "]}";
+    return out.str();
+}
+
+//Route для всех упорядоченных пар остановок, одна RouteMatrix на все пары и Isochrone из каждой остановки
+std::string MakeRequestsInput(const Network& network, const std::string& file) {
+    std::ostringstream out;
+    out << R"({"serialization_settings": {"file": ")" << file << R"("}, "stat_requests": [)";
+    int id = 0;
+    for (const std::string& from : network.stops) {
+        for (const std::string& to : network.stops) {
+            out << R"({"id": )" << id++ << R"(, "type": "Route", "from": ")" << from << R"(", "to": ")" << to << R"("},)";
+        }
+    }
+    out << R"({"id": )" << id++ << R"(, "type": "RouteMatrix", "sources": [)";
+    for (size_t i = 0; i < network.stops.size(); ++i) {
+        out << (i > 0 ? ", "sv : ""sv) << '"' << network.stops[i] << '"';
+    }
+    out << R"(], "targets": [)";
+    for (size_t i = 0; i < network.stops.size(); ++i) {
+        out << (i > 0 ? ", "sv : ""sv) << '"' << network.stops[i] << '"';
+    }
+    out << "]}";
+    for (const std::string& from : network.stops) {
+        out << R"(, {"id": )" << id++ << R"(, "type": "Isochrone", "from": ")" << from
+            << R"(", "time_limit": )" << ISOCHRONE_LIMIT << '}';
+    }
+    out << "]}";
+    return out.str();
+}
+
+size_t FindStop(const Network& network, const std::string& name) {
+    for (size_t i = 0; i < network.stops.size(); ++i) {
+        if (network.stops[i] == name) {
+            return i;
+        }
+    }
+    throw std::runtime_error("Unknown stop "s + name);
+}
+
+//items — настоящие поездки: ожидание на текущей остановке, затем span_count перегонов одного автобуса
+void CheckRouteItems(const Network& network, const json::Array& items, size_t from, size_t to, int wait_time,
+                     double total_time) {
+    const double velocity = BUS_VELOCITY * 1000. / 60.;
+    size_t current = from;
+    double time_sum = 0.;
+    for (size_t i = 0; i < items.size(); i += 2) {
+        Check(i + 1 < items.size(), "route items are not Wait/Bus pairs"s);
+        const json::Dict& wait = items[i].AsMap();
+        const json::Dict& ride = items[i + 1].AsMap();
+        Check(wait.at("type"sv).AsString() == "Wait"s && ride.at("type"sv).AsString() == "Bus"s,
+              "route items are not Wait/Bus pairs"s);
+        Check(FindStop(network, wait.at("stop_name"sv).AsString()) == current, "Wait is not at the current stop"s);
+        Check(IsClose(wait.at("time"sv).AsDouble(), wait_time), "Wait time differs from bus_wait_time"s);
+        const std::string& bus_name = ride.at("bus"sv).AsString();
+        const std::vector<size_t>& path = network.bus_paths.at(std::stoul(bus_name.substr("Bus "s.size())));
+        const size_t span = static_cast<size_t>(ride.at("span_count"sv).AsInt());
+        const double ride_time = ride.at("time"sv).AsDouble();
+        bool found = false;
+        for (size_t start = 0; !found && start + span < path.size(); ++start) {
+            if (path[start] != current || span == 0) {
+                continue;
+            }
+            double expected = 0.;
+            for (size_t k = start; k < start + span; ++k) {
+                expected += network.GetDistance(path[k], path[k + 1]) / velocity;
+            }
+            if (IsClose(expected, ride_time)) {
+                current = path[start + span];
+                found = true;
+            }
+        }
+        Check(found, bus_name + " has no ride of "s + std::to_string(span) + " stops with the reported time"s);
+        time_sum += wait.at("time"sv).AsDouble() + ride_time;
+    }
+    Check(current == to, "route ends at a wrong stop"s);
+    Check(IsClose(time_sum, total_time), "items do not add up to total_time"s);
+}
+
+void CheckAnswers(const Network& network, const std::vector<std::vector<double>>& expected, int wait_time,
+                  const json::Array& answers) {
+    const size_t n = network.stops.size();
+    Check(answers.size() == n * n + 1 + n, "wrong number of answers"s);
+    for (size_t from = 0; from < n; ++from) {
+        for (size_t to = 0; to < n; ++to) {
+            const json::Dict& answer = answers[from * n + to].AsMap();
+            const std::string route = network.stops[from] + " -> "s + network.stops[to] + ": "s;
+            if (expected[from][to] == INF) {
+                Check(answer.count("error_message"sv) > 0, route + "found a route to an unreachable stop"s);
+                continue;
+            }
+            Check(answer.count("total_time"sv) > 0, route + "route not found"s);
+            const double total_time = answer.at("total_time"sv).AsDouble();
+            Check(IsClose(total_time, expected[from][to]),
+                  route + "total_time "s + std::to_string(total_time) + ", expected "s + std::to_string(expected[from][to]));
+            try {
+                CheckRouteItems(network, answer.at("items"sv).AsArray(), from, to, wait_time, total_time);
+            } catch (const std::exception& e) {
+                throw std::runtime_error(route + e.what());
+            }
+        }
+    }
+
+    const json::Array& matrix = answers[n * n].AsMap().at("total_times"sv).AsArray();
+    for (size_t from = 0; from < n; ++from) {
+        const json::Array& row = matrix.at(from).AsArray();
+        for (size_t to = 0; to < n; ++to) {
+            const std::string cell = "RouteMatrix "s + network.stops[from] + " -> "s + network.stops[to] + ": "s;
+            if (expected[from][to] == INF) {
+                Check(row.at(to).IsNull(), cell + "unreachable stop has a time"s);
+            } else {
+                Check(!row.at(to).IsNull() && IsClose(row.at(to).AsDouble(), expected[from][to]), cell + "wrong time"s);
+            }
+        }
+    }
+
+    for (size_t from = 0; from < n; ++from) {
+        const std::string request = "Isochrone from "s + network.stops[from] + ": "s;
+        std::vector<bool> reported(n, false);
+        for (const json::Node& item : answers[n * n + 1 + from].AsMap().at("stops"sv).AsArray()) {
+            const size_t stop = FindStop(network, item.AsMap().at("stop_name"sv).AsString());
+            Check(stop != from, request + "origin is listed"s);
+            Check(IsClose(item.AsMap().at("time"sv).AsDouble(), expected[from][stop]), request + "wrong time"s);
+            reported[stop] = true;
+        }
+        for (size_t stop = 0; stop < n; ++stop) {
+            //время у самого предела при весах float может оказаться по любую его сторону
+            if (stop == from || IsClose(expected[from][stop], ISOCHRONE_LIMIT)) {
+                continue;
+            }
+            Check(reported[stop] == (expected[from][stop] <= ISOCHRONE_LIMIT),
+                  request + network.stops[stop] + (reported[stop] ? " is beyond the limit"s : " is missing"s));
+        }
+    }
+}
+
+json::Array RunCombination(const Network& network, const std::string& file, const std::string& format,
+                           const std::string& router_type, const std::string& graph_model, int wait_time) {
+    {
+        std::istringstream input(MakeBaseInput(network, file, format, router_type, graph_model, wait_time));
+        transport_catalogue::TransportCatalogue catalogue;
+        RequestHandler request_handler(catalogue, input);
+        request_handler.ReadInputDocument(true);
+        request_handler.AddInfo();
+        request_handler.CreateGraph();
+        request_handler.Serialize(true);
+    }
+    std::istringstream input(MakeRequestsInput(network, file));
+    std::ostringstream output;
+    transport_catalogue::TransportCatalogue catalogue;
+    RequestHandler request_handler(catalogue, input, output);
+    request_handler.ReadInputDocument();
+    request_handler.DeserializeForRequests(true);
+    request_handler.GetAnswers();
+    request_handler.PrintAnswers();
+    std::istringstream answers(output.str());
+    return json::Load(answers).GetRoot().AsArray();
+}
+
+}
+
+int main() {
+    const Network network = GenerateNetwork();
+    const std::filesystem::path file = std::filesystem::temp_directory_path() / "transport_router_test.db"s;
+    int failures = 0;
+    int combinations = 0;
+    for (const int wait_time : WAIT_TIMES) {
+        const std::vector<std::vector<double>> expected = ComputeExpectedTimes(network, wait_time);
+        for (const std::string& router_type : ROUTER_TYPES) {
+            for (const std::string& graph_model : GRAPH_MODELS) {
+                for (const std::string& format : FORMATS) {
+                    ++combinations;
+                    const std::string name = router_type + " / "s + graph_model + " / "s + format
+                            + " / bus_wait_time "s + std::to_string(wait_time);
+                    try {
+                        CheckAnswers(network, expected, wait_time,
+                                     RunCombination(network, file.string(), format, router_type, graph_model, wait_time));
+                    } catch (const std::exception& e) {
+                        std::cerr << "FAILED "sv << name << ": "sv << e.what() << '\n';
+                        ++failures;
+                    }
+                }
+            }
+        }
+    }
+    std::filesystem::remove(file);
+    std::cout << combinations - failures << " of "sv << combinations << " combinations passed\n"sv;
+    return failures == 0 ? 0 : 1;
+}